@@ -0,0 +1,104 @@
+#include <gd/gd.h>
+#include <gd/grep.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+#include "generator.h"
+
+using namespace gd;
+using namespace gd::shorthand; // add >>, || chaining
+using namespace std;
+
+inline void assertError(char const * msg, const string& err)
+{
+  throw runtime_error(""s + msg + "\n   " +  err );
+}
+
+// Count the occurrences of a pattern in the files of a branch, with gd::grep and with `git grep`,
+// on the same bare repository. Both are run cold (first) and warm, git grep is a process per run.
+//
+// `git grep -F -o` prints a line per occurrence, the random content holds no line breaks and the
+// patterns don't overlap themselves, so both count the same occurrences.
+//
+// libgit2 verifies the hash of every object it reads, git doesn't, so gd::grep is also run without it.
+//
+// Output (-O2 build, 13,000 files of 10,000 bytes in loose objects, a single core, avx2)
+// gd::grep           "Gd4" :: 533 occurrences ::    1.39783s (cold)    1.75668s (warm)
+// gd::grep (no hash) "Gd4" :: 533 occurrences ::   0.971368s (cold)    1.03813s (warm)
+// git grep           "Gd4" :: 533 occurrences ::    1.21276s (cold)    1.14234s (warm)
+void grepTest(const vector<string>& patterns)
+{
+  constexpr size_t numFiles(1'000);
+  constexpr size_t maxFileSize(10'000);
+  const string repoPath = "/tmp/test/grepTest";
+  const std::vector<std::string> domains{ "AB", "AS", "UT", "AC", "RT", "TZ", "AD", "AZ", "PT", "RS", "TV", "VZ", "ZZ"};
+
+  cleanRepo(repoPath);
+  auto dbx = selectRepository(repoPath);
+  for (const auto& domain :  domains)
+    for (const auto& [id, content] : hsh::elements(numFiles,  maxFileSize))
+      dbx >> add(domain + "/" + id, content);
+
+  dbx >> commit("grep", "grep@here.com", "grep commit\n")
+      || [](const auto& err) -> Result<gd::Context> { assertError("Commit failed", err); return gd_unexpected(err); };
+
+  auto threads = max(thread::hardware_concurrency(), 1u);
+  cout << "Kernel " << grepKernel() << ", " << threads << " threads, " << domains.size() * numFiles << " files" << endl;
+
+  auto time = [](auto&& work) {
+    auto start = chrono::steady_clock::now();
+    auto count = work();
+    return make_pair(count, chrono::duration <double> (chrono::steady_clock::now() - start).count());
+  };
+
+  for (const auto& pattern : patterns) {
+    auto gdGrep = [&] {
+      size_t count = 0;
+      for (auto&& match : grep(*dbx, "main", {pattern}))
+        if (!match)
+          assertError("Grep failed", match.error()._msg);
+        else
+          ++count;
+      return count;
+    };
+
+    auto gitGrep = [&] {
+      auto cmd = "git --git-dir=" + repoPath + " grep --threads " + to_string(threads) + " -F -o '" + pattern + "' main";
+      auto out = popen(cmd.c_str(), "r");
+      if (!out)
+        assertError("git grep failed", cmd);
+
+      size_t count = 0;
+      for (int c; (c = fgetc(out)) != EOF;)
+        count += c == '\n';
+      pclose(out);
+      return count;
+    };
+
+    auto report = [&](const string& label, auto&& work) {
+      auto [count, cold] = time(work);
+      auto [_, warm] = time(work);
+      cout << label << " \"" << pattern << "\" :: " << count << " occurrences :: "
+           << setw(10) << cold << "s (cold) " << setw(10) << warm << "s (warm)" << endl;
+    };
+
+    report("gd::grep          ", gdGrep);
+    tune({.verifyHashes_ = false}); // git doesn't verify the objects it reads
+    report("gd::grep (no hash)", gdGrep);
+    tune({.verifyHashes_ = true});
+    report("git grep          ", gitGrep);
+  }
+}
+
+int main() {
+
+  grepTest({"Gd4", "needle"});
+
+  return 0;
+}
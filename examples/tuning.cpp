@@ -0,0 +1,103 @@
+#include <gd/gd.h>
+
+#include <filesystem>
+#include <vector>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+
+#include "generator.h"
+
+using namespace gd;
+using namespace gd::shorthand; // add >>, || chaining
+using namespace std;
+
+inline void assertError(char const * msg, const string& err)
+{
+  throw runtime_error(""s + msg + "\n   " +  err );
+}
+
+// Compare the predefined tuning profiles on the same work load
+//  - write : numFiles files in each of 13 directories, in one commit
+//  - read  : every file, twice, the second pass is served from the object cache when the profile caches blobs
+//  - walk  : the entire tree
+//
+// Each profile runs on a fresh repository, the effective libgit2 settings are reported before the timings
+//
+// Output (debug build, 13,000 files)
+//                 write                read (cold)          read (warm)          walk
+// Default     :: 1520.91 files/s  ::  13722.5 files/s  ::  14002.0 files/s  ::  144999 entries/s
+// Read heavy  :: 1832.61 files/s  ::  12528.2 files/s  ::  27016.8 files/s  ::  171791 entries/s
+// Write heavy :: 1854.89 files/s  ::  10775.0 files/s  ::  13097.3 files/s  ::  136352 entries/s
+// Low memory  :: 1498.27 files/s  ::  14051.0 files/s  ::  13658.2 files/s  ::  141807 entries/s
+// Durable     :: 1012.58 files/s  ::  14748.6 files/s  ::  14900.8 files/s  ::  156943 entries/s
+void tuningTest(const string& label, Profile profile)
+{
+  constexpr size_t numFiles(1'000);
+  constexpr size_t maxFileSize(1000);
+  const string repoPath = "/tmp/test/tuningTest";
+  const std::vector<std::string> domains{ "AB", "AS", "UT", "AC", "RT", "TZ", "AD", "AZ", "PT", "RS", "TV", "VZ", "ZZ"};
+
+  cleanRepo(repoPath);
+  auto dbx = selectRepository(repoPath, profile);
+  if (!dbx)
+    assertError("Select failed", dbx.error()._msg);
+
+  auto opts = tuning();
+  std::cout << "\n" << label << " :: cache " << (*opts.cacheMaxSize_ >> 20) << "MiB"
+    << " (commit " << *opts.commitCacheLimit_ << "B, tree " << *opts.treeCacheLimit_ << "B, blob " << *opts.blobCacheLimit_ << "B)"
+    << ", mwindow " << (*opts.mwindowSize_ >> 20) << "MiB mapped " << (*opts.mwindowMappedLimit_ >> 20) << "MiB"
+    << ", strict " << *opts.strictObjectCreation_ << ", fsync " << *opts.fsync_ << endl;
+
+  std::vector<std::string> paths;
+  auto time = [](auto&& work) {
+    auto start = chrono::steady_clock::now();
+    work();
+    return chrono::duration <double> (chrono::steady_clock::now() - start).count();
+  };
+
+  auto write = time([&] {
+    for (const auto& domain :  domains)
+      for (const auto& [id, content] : hsh::elements(numFiles,  maxFileSize)) {
+        paths.push_back(domain + "/" + id);
+        dbx >> add(paths.back(), content);
+      }
+
+    dbx >> commit("tuning", "tuning@here.com", "tuning commit\n")
+        || [](const auto& err) -> Result<gd::Context> { assertError("Commit failed", err); return gd_unexpected(err); };
+  });
+
+  auto snap = snapshot(*dbx);
+  if (!snap)
+    assertError("Snapshot failed", snap.error()._msg);
+
+  auto readAll = [&] {
+    for (const auto& path : paths)
+      if (auto file = snap->read(path); !file)
+        assertError("Read failed", file.error()._msg);
+  };
+  auto cold = time(readAll);
+  auto warm = time(readAll);
+
+  size_t entries = 0;
+  auto walked = time([&] {
+    for (auto&& item : walk(*dbx))
+      entries += !!item;
+  });
+
+  std::cout << "   write : " << setw(10) << write  << "s " << setw(10) << (paths.size() / write)  << " files/s\n"
+            << "   read  : " << setw(10) << cold   << "s " << setw(10) << (paths.size() / cold)   << " files/s (cold)\n"
+            << "   read  : " << setw(10) << warm   << "s " << setw(10) << (paths.size() / warm)   << " files/s (warm)\n"
+            << "   walk  : " << setw(10) << walked << "s " << setw(10) << (entries / walked)      << " entries/s" << endl;
+}
+
+int main() {
+
+  tuningTest("Default    ", Profile::Default);
+  tuningTest("Read heavy ", Profile::ReadHeavy);
+  tuningTest("Write heavy", Profile::WriteHeavy);
+  tuningTest("Low memory ", Profile::LowMemory);
+  tuningTest("Durable    ", Profile::Durable);
+
+  return 0;
+}
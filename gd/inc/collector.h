@@ -1,5 +1,6 @@
 #pragma once 
 #include <map>
+#include <set>
 #include <vector>
 #include <filesystem>
 #include <cstring>
@@ -69,6 +70,14 @@ namespace gd {
       static Result<gd::ObjectUpdate> 
       fromEntry(gd::Context& ctx,const std::filesystem::path& fullpath, const git_tree_entry* entry) noexcept;
 
+      /// @brief Links an existing blob on a 'fullpath' location, without resupplying its content
+      /// @param ctx The context used to access the repository
+      /// @param fullpath Full path of the blob including the actual file name
+      /// @param blobId The `git_oid` of a blob already in the repository
+      /// @return On success the Object representation of the Blob, otherwise an error (i.e. not a known blob).
+      static Result<ObjectUpdate>
+      fromBlob(gd::Context& ctx, const std::filesystem::path& fullpath, git_oid const * blobId) noexcept;
+
       /// @brief Creates a Tree/Directory 
       /// @param fullpath Full path of the directory including the directory name 
       /// @param builder The git treebuilder of a for the given directory
@@ -137,6 +146,14 @@ namespace gd {
     Result<void> 
     insertEntry(gd::Context& ctx, const std::filesystem::path& fullpath, const git_tree_entry* entry) noexcept;
 
+    /// @brief Inserts an existing blob (by id) into a directory
+    /// @param ctx the context used to access the repository
+    /// @param fullpath Full path of a file(or in gitspeak Blob) including filename
+    /// @param blobId The `git_oid` of a blob already in the repository
+    /// @return On success nothing, and Error otherwise.
+    Result<void>
+    insertBlob(gd::Context& ctx, const std::filesystem::path& fullpath, git_oid const * blobId) noexcept;
+
     /// @brief Removes a File (Tree or Blob) 
     /// @param ctx the context used to access the repository
     /// @param fullpath Full path of the File
@@ -166,5 +183,35 @@ namespace gd {
     /// @return On success returns a blob, otherwise an Error
     Result<gd::blob_t> 
     getBlobByPath(const Context& ctx, const std::filesystem::path& fullpath) const noexcept; 
+
+    /// @brief Retrieves the latest collected update of a file or directory
+    /// @param fullpath The full path of the updated entry
+    /// @return The latest update, or nullptr if `fullpath` was not updated since the last commit
+    ObjectUpdate const *
+    find(const std::filesystem::path& fullpath) const noexcept;
+
+    /// @brief Tests whether a directory's committed entries were removed, by a collected removal of the
+    ///        directory or of one of its ancestors. Entries updated since are kept.
+    /// @param dir The directory, relative to the root
+    /// @return True if the latest update of the directory (or of an ancestor) is a removal
+    bool
+    removed(const std::filesystem::path& dir) const noexcept;
+
+    /// @brief The latest collected update of every entry directly under a directory
+    /// @param dir The directory, relative to the root
+    /// @return A name to update map, where later updates override earlier ones
+    std::map<std::string, ObjectUpdate>
+    pending(const std::filesystem::path& dir) const noexcept;
+
+    /// @brief Names of the subdirectories of `dir` that are implicitly created (or updated) by collected updates
+    /// @param dir The directory, relative to the root
+    /// @return The set of direct subdirectory names with updates at any depth below them
+    std::set<std::string>
+    pendingDirs(const std::filesystem::path& dir) const noexcept;
+
+    /// @brief The latest collected update of every updated file or directory
+    /// @return A full path to update map
+    std::map<std::filesystem::path, ObjectUpdate>
+    changes() const noexcept;
   };
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ namespace gd {
     InitialContext,
     Deleted, 
     NotFound,
+    Conflict,    /* A file read by a serializable context changed before its commit */
     Application, /* Generic Application error */
   };
 
@@ -0,0 +1,112 @@
+#pragma once
+#include <gd/gd.h>
+#include <task.h>
+
+#include <coroutine>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+/**
+ * Coroutine flavour of the chained operations, for many logical sessions over a handful of threads.
+ *
+ * An operation is awaited (i.e. `ctx = co_await async::add(std::move(ctx), "a", "b")`), the awaiting coroutine is
+ * suspended while the operation's blocking (libgit2) work runs on an internal I/O pool, and is resumed by
+ * the pool's thread once the work is done. Any chained operation is awaited by `async::then`.
+ *
+ * Sessions are `Task<Result<Context>>` coroutines, run by `syncWait` (or concurrently, by `whenAll`).
+ *
+ * Example:
+ *   Task<Result<Context>> session(std::string branch) {
+ *     auto ctx = co_await async::selectRepository("/tmp/repo");
+ *     ctx = co_await async::then(std::move(ctx), selectBranch(branch));
+ *     ctx = co_await async::add(std::move(ctx), "the/blank/slate", "...");
+ *     co_return co_await async::commit(std::move(ctx), "me", "me@here.com", "async");
+ *   }
+ **/
+namespace gd
+{
+  namespace internal {
+    /// @brief Queues work to the I/O pool, started by the first work queued
+    void postIo(std::function<void()> work) noexcept;
+  }
+
+  namespace async {
+    /// @brief Awaits a work run by the I/O pool, the awaiting coroutine is resumed by the pool's thread
+    template<typename F>
+    class Offload {
+      public:
+      using Value = std::invoke_result_t<F&>;
+
+      explicit Offload(F work) noexcept
+      : work_{ std::move(work) } {}
+
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        internal::postIo([this, awaiting] {
+          value_.emplace(work_());
+          awaiting.resume();
+        });
+      }
+      Value await_resume() noexcept { return std::move(*value_); }
+
+      private:
+      F                    work_;
+      std::optional<Value> value_;
+    };
+
+    /// @brief Runs a chained operation (i.e. `selectBranch(name)`) on the I/O pool
+    /// @param ctx The context, propagated as is when it's an Error
+    /// @param op The operation, its arguments are required to outlive the await
+    /// @return An awaitable of the operation's result
+    template<typename Op>
+    auto then(Result<Context>&& ctx, Op op) noexcept
+    {
+      return Offload([ctx = std::move(ctx), op = std::move(op)]() mutable {
+        return std::move(ctx).and_then(op);
+      });
+    }
+
+    /// @brief Selects (opens, or creates) a repository on the I/O pool, see `gd::selectRepository`
+    inline auto selectRepository(std::filesystem::path fullpath) noexcept
+    {
+      return Offload([fullpath = std::move(fullpath)] {
+        return gd::selectRepository(fullpath);
+      });
+    }
+
+    /// @brief Adds a file on the I/O pool, see `gd::add`
+    inline auto add(Result<Context>&& ctx, std::string fullpath, std::string content) noexcept
+    {
+      return Offload([ctx = std::move(ctx), fullpath = std::move(fullpath), content = std::move(content)]() mutable {
+        return std::move(ctx).and_then(gd::add(fullpath, content));
+      });
+    }
+
+    /// @brief Deletes a file on the I/O pool, see `gd::del`
+    inline auto del(Result<Context>&& ctx, std::string fullpath) noexcept
+    {
+      return Offload([ctx = std::move(ctx), fullpath = std::move(fullpath)]() mutable {
+        return std::move(ctx).and_then(gd::del(fullpath));
+      });
+    }
+
+    /// @brief Reads a file on the I/O pool, see `gd::read`
+    inline auto read(Result<Context>&& ctx, std::filesystem::path fullpath) noexcept
+    {
+      return Offload([ctx = std::move(ctx), fullpath = std::move(fullpath)]() mutable {
+        return std::move(ctx).and_then(gd::read(fullpath));
+      });
+    }
+
+    /// @brief Commits the collected updates on the I/O pool, see `gd::commit`
+    inline auto commit(Result<Context>&& ctx, std::string author, std::string email, std::string message) noexcept
+    {
+      return Offload([ctx = std::move(ctx), author = std::move(author), email = std::move(email),
+                      message = std::move(message)]() mutable {
+        return std::move(ctx).and_then(gd::commit(author, email, message));
+      });
+    }
+  }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <gd/gd.h>
+
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * An index of commit metadata, i.e. "what did X commit between 10:00 and 11:00 on branch Y", without walking the DAG.
+ *
+ * Commits are appended by `ni::commit` once `keepCommitIndex` was called for the repository, to a single append
+ * only file kept next to the repository's objects in `<repository>/gd-commits`, a record per commit (on any branch).
+ *
+ * Loaded records are ordered by time, and listed per author (by name and by email):
+ *  - A time range is found by a binary search, of all the commits or of an author's
+ *  - Ref and message terms (see `TextIndex::terms`) filter the commits in range
+ **/
+namespace gd
+{
+  struct CommitRecord {
+    git_oid                               commit_;  /* The commit                                   */
+    std::optional<git_oid>                parent_;  /* Its parent, nullopt for a root commit        */
+    std::string                           ref_;     /* The ref committed to, i.e. "refs/heads/main" */
+    std::string                           author_;  /* Author name                                  */
+    std::string                           email_;   /* Author email                                 */
+    std::chrono::system_clock::time_point time_;    /* Commit time, in seconds                      */
+    std::vector<std::string>              terms_;   /* The message's terms, sorted                  */
+  };
+
+  struct CommitQuery {
+    std::optional<std::chrono::system_clock::time_point> since_;  /* Only commits at or after           */
+    std::optional<std::chrono::system_clock::time_point> until_;  /* Only commits at or before          */
+    std::string author_;   /* Author name or email (case insensitive), empty for any                  */
+    std::string ref_;      /* Full ref or branch name, empty for any                                  */
+    std::string message_;  /* Terms the message holds (all of them), empty for any                    */
+    size_t      limit_ = std::numeric_limits<size_t>::max(); /* Maximal number of commits            */
+  };
+
+  struct CommitTable;
+
+  /// @brief A snapshot of a repository's commit index, later commits aren't seen
+  class CommitIndex {
+    public:
+
+    /// @brief Loads the index of the context's repository, reading only records appended since the last load
+    /// @return On success the index, possibly empty, otherwise an Error
+    static Result<CommitIndex> open(const Context& ctx) noexcept;
+
+    /// @brief Finds commits
+    /// @return The commits matching every criteria of the query, oldest first
+    std::vector<CommitRecord> find(const CommitQuery& query) const noexcept;
+
+    /// @brief The number of commits indexed
+    size_t size() const noexcept;
+
+    private:
+    explicit CommitIndex(std::shared_ptr<const CommitTable> table) noexcept
+    : table_{ std::move(table) } {}
+
+    std::shared_ptr<const CommitTable> table_;
+  };
+
+  namespace internal {
+    /// @brief Appends a new commit to the index
+    /// @param repo The repository
+    /// @param commitId The new commit
+    /// @param parentId The commit's parent, nullptr for a root commit
+    /// @param ref The ref committed to, "HEAD" is resolved to its branch
+    /// @param author The commit's author and time
+    /// @param message The commit's message, only its terms are kept
+    /// @return On success nothing, otherwise an Error
+    Result<void> appendCommit(git_repository* repo, const git_oid& commitId, git_oid const* parentId,
+                              const std::string& ref, const git_signature* author, const std::string& message) noexcept;
+
+    /// @brief Forgets the loaded index of a repository, i.e. when it's removed
+    void dropCommitIndex(git_repository* repo) noexcept;
+  }
+}
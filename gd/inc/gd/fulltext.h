@@ -0,0 +1,105 @@
+#pragma once
+#include <gd/gd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Full text search over the files of a branch, at its tip or at any indexed commit.
+ *
+ * The index is an inverted index (term -> postings of paths), kept next to the repository's objects
+ * in `<repository>/gd-fulltext/<hex ref>`, and updated per commit from the changed files only:
+ *  - Every indexed commit gets a sequence number, along the branch's first parent chain
+ *  - A commit's changes are written as an immutable segment, its postings carry the commit's sequence
+ *    number and whether the term was added to the path, or removed from it (a tombstone)
+ *  - A search at a commit only considers postings up to the commit's sequence number, the latest posting
+ *    of a (term, path) decides whether the path holds the term
+ *  - Segments are merged (adjacent, smallest first) to bound their count. Merging keeps every posting,
+ *    so old commits remain searchable
+ **/
+namespace gd
+{
+  struct TextIndexOptions {
+    size_t maxSegments_ = 8;    /* Segments kept, adjacent segments are merged beyond it       */
+    bool   live_        = true; /* Index every commit to the branch, otherwise only on `update` */
+  };
+
+  class TextIndex {
+    public:
+
+    struct Posting {
+      std::string path_;  /* The file's full path                        */
+      uint64_t    seq_;   /* Sequence number of the commit                */
+      bool        live_;  /* Term added to the file, otherwise removed     */
+    };
+
+    struct Segment {
+      uint64_t    first_;  /* Sequence number of the first commit covered */
+      uint64_t    last_;   /* Sequence number of the last commit covered  */
+      std::string file_;   /* File name, in the index directory           */
+      std::map<std::string, std::vector<Posting>> postings_; /* Term -> postings */
+
+      size_t size() const noexcept;
+    };
+
+    /// @brief Opens (or creates) the full text index of the context's branch, and catches up with its tip
+    /// @param ctx The context whose repository and branch are indexed, it isn't required to outlive the index
+    /// @param opts Merge policy and live update
+    /// @return On success the index, otherwise an Error
+    static Result<std::shared_ptr<TextIndex>>
+    open(const Context& ctx, TextIndexOptions opts = {}) noexcept;
+
+    ~TextIndex();
+
+    /// @brief Indexes the branch's commits since the last indexed one, one segment per commit
+    /// @return On success the number of commits indexed, otherwise an Error
+    ///
+    /// NOTE: Live updates run on the I/O pool after the commit returns, a search may not see the
+    ///       latest commits yet. Calling `update` catches up. A failed live update is caught up by
+    ///       the next commit or `update`
+    Result<size_t> update() noexcept;
+
+    /// @brief Finds the files holding every term of `query`, at the last indexed commit
+    /// @return On success the paths, sorted, otherwise an Error
+    Result<std::vector<std::filesystem::path>>
+    search(const std::string& query) const noexcept;
+
+    /// @brief Finds the files holding every term of `query`, at an indexed commit of the branch
+    /// @return On success the paths, sorted, otherwise an Error (i.e. NotFound for a commit not indexed)
+    Result<std::vector<std::filesystem::path>>
+    search(const std::string& query, const git_oid& commitId) const noexcept;
+
+    /// @brief The number of segments, bound by `TextIndexOptions::maxSegments_`
+    size_t segments() const noexcept;
+
+    /// @brief Splits content to terms: lower cased runs of ASCII letters and digits, each term once
+    static std::vector<std::string> terms(const std::string& content) noexcept;
+
+    private:
+    TextIndex(repository_t* repo, std::string ref, std::filesystem::path dir, TextIndexOptions opts) noexcept;
+
+    Result<void> load() noexcept;
+    Result<void> index(const Context& ctx, std::optional<git_oid> from, const git_oid& to) noexcept;
+    Result<void> merge() noexcept;
+    Result<void> save() const noexcept;
+
+    std::vector<std::filesystem::path> find(const std::string& query, uint64_t seq) const noexcept;
+
+    repository_t*                   repo_;
+    std::string                     ref_;
+    std::filesystem::path           dir_;
+    TextIndexOptions                opts_;
+    std::optional<size_t>           observer_;
+    std::atomic<bool>               queued_{false}; /* A live update is queued to the I/O pool */
+
+    mutable std::shared_mutex       lock_;
+    std::vector<git_oid>            commits_;   /* Indexed commits, commits_[seq - 1]  */
+    std::map<std::string, uint64_t> seqs_;      /* Raw commit id -> sequence number    */
+    std::vector<Segment>            segments_;  /* Ordered by the commits covered      */
+  };
+}
@@ -3,26 +3,28 @@
 
 #include <string>
 #include <set>
+#include <chrono>
+#include <variant>
 #include <memory>
 #include <ostream>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <limits>
 #include <map>
+#include <optional>
+#include <vector>
 #include <err.h>
 #include <expected.h>
 #include <guard.h>
 #include <collector.h>
+#include <lazy.h>
 #include <spdlog/spdlog.h>
 
 /**
  * C⊕rdoba creates and manages a standard git repository. For operations not yet directly
  * supported by the library, the repository can be manipulated using git CLI tools.
  *
- * TODO: Review functionality of Thread local context
- *       First the updates are not shared between local variable and local thread context 
- *       Re-think the semantics of local thread context, 
- *        is it interchangable 
- *        when should it be destructed? Additional API with callers responsibility.
- * 
  * TODO: Support for sharding. 
  *
  * Not yet directly supported (use git CLI):
@@ -44,7 +46,7 @@ namespace gd
     struct Node {
 
       Node() noexcept
-      :commitId_{nullptr} {}
+      :commitId_{nullptr}, generation_{0} {}
       Node(Node&& other) noexcept;
       Node& operator=(Node&& other) noexcept;
 
@@ -67,14 +69,14 @@ namespace gd
        * @warning if multiple threads contribute to the same reference's evolution, serizlization is required by caller, or 
        * the update risks not refelecting the last of reference. 
        **/ 
-      Result<void> rebase(const gd::Context& ctx) noexcept;
+      Result<void> rebase(const gd::Context& ctx, bool refresh = false) noexcept;
 
       /**
       /* @brief returns the tip of reference
        * @param ctx The old context, with valid repository/reference 
       /* @return On success a git_oid of the reference's tip, otherwise and error
       **/
-      Result<git_oid const*> tip(const gd::Context& ctx) noexcept;
+      Result<git_oid> tip(const gd::Context& ctx) noexcept;
 
       /**
        * @brief tests if the context is at the tip of the reference
@@ -91,6 +93,9 @@ namespace gd
 
       /// @brief Root tree of the commit
       tree_t root_;
+
+      /// @brief The generation of the reference's tip the node was synced with, 0 when unknown
+      uint64_t generation_;
     };
   };
 
@@ -107,10 +112,13 @@ namespace gd
 
     internal::Node tip_;     /* Internal call chaining information */
 
+    /// @brief Files read from the tip (path -> blob oid, nullopt when absent), recorded once serializable
+    std::optional<std::map<std::string, std::optional<git_oid>>> reads_;
+
     Context(repository_t* repo,
             const std::string& branch = defaultRef ) noexcept
     : repo_(repo), ref_(branch) { 
-      if (repo) rebase(); 
+      if (repo) tip_.rebase(*this); 
     }
 
     Context(Context&& other ) noexcept  = default;
@@ -124,8 +132,8 @@ namespace gd
     git_oid const * getCommitId() const noexcept;
 
     Result<void> update(git_oid const * commitId) noexcept { return tip_.update(*this, commitId); }
-    Result<void> rebase() noexcept { return tip_.rebase(*this); }
-    Result<git_oid const *> tip() noexcept { return tip_.tip(*this); }
+    Result<void> rebase() noexcept { return tip_.rebase(*this, true); }
+    Result<git_oid> tip() noexcept { return tip_.tip(*this); }
     Result<bool> isTip() noexcept { return tip_.isTip(*this); }
 
   };
@@ -141,11 +149,46 @@ namespace gd
     const std::string& content() const noexcept { return content_; }
   };
 
+  /// @brief A directory entry, served from the tree object without loading the blob
+  struct Entry {
+    std::string    name_;  /* Entry name, without its directory                      */
+    git_object_t   type_;  /* GIT_OBJECT_BLOB(file) or GIT_OBJECT_TREE(directory)    */
+    git_oid        oid_;   /* Object id, zero for a not yet written (new) directory  */
+    git_filemode_t mode_;  /* Entry's file mode                                      */
+    size_t         size_;  /* Object size in bytes, as recorded in its header         */
+  };
+
+  class ListContext : public Context {
+    std::vector<Entry> entries_;
+
+    public:
+    ListContext(Context&& ctx, std::vector<Entry>&& entries) noexcept
+    : Context{ std::move(ctx) }, entries_{ std::move(entries)}
+    { }
+
+    const std::vector<Entry>& entries() const noexcept { return entries_; }
+  };
+
+  /// @brief A point in history: a revision string (i.e. "main~2", a tag or hex oid), a commit id, or a point in time
+  using Revision = std::variant<std::string, git_oid, std::chrono::system_clock::time_point>;
+
+  /// @brief A secondary index, maps keys extracted from files' content to the files' paths
+  ///        Entries are stored in the repository, as `.gd/index/<name>/<hex key>/<hex path>` -> the file's blob,
+  ///        and maintained on commit from the committed updates only
+  struct Index {
+    using Keys = std::function<std::vector<std::string>(const std::filesystem::path& fullpath, const std::string& content)>;
+
+    std::string           name_;    /* The index name, unique per repository                    */
+    std::filesystem::path prefix_;  /* Only files under prefix are indexed, empty for all files */
+    Keys                  keys_;    /* Extracts a file's keys, none when not indexed. Mustn't throw */
+  };
+
   namespace ni
   {
     Result<Context> selectBranch(Context&& ctx, const std::string& name) noexcept;
     Result<Context> add(Context&& ctx, const std::filesystem::path& fullpath, const std::string& content) noexcept;
     Result<Context> rm(Context&& ctx, const std::string& fullpath) noexcept;
+    Result<Context> addById(Context&& ctx, const std::filesystem::path& fullpath, const git_oid& blobId) noexcept;
     Result<Context> mv(Context&& ctx, const std::string& fullpath, const std::string& toFullpath) noexcept;
     Result<Context> createBranch(Context&& ctx, const git_oid* commitId, const std::string& name) noexcept;
     Result<Context> createBranch(Context&& ctx, const std::string& name) noexcept;
@@ -154,8 +197,319 @@ namespace gd
 
     Result<ReadContext> read(Context&& ctx, const std::filesystem::path& fullpath) noexcept;
     Result<gd::ReadContext> readblob(gd::Context&& ctx, git_blob* blob, const std::filesystem::path& fullpath) noexcept;
+    Result<ListContext> list(Context&& ctx, const std::filesystem::path& dir) noexcept;
+    Result<ReadContext> readAt(Context&& ctx, const std::filesystem::path& fullpath, const Revision& rev) noexcept;
+    Result<ReadContext> readById(Context&& ctx, const git_oid& blobId) noexcept;
+    Result<ReadContext> readRange(Context&& ctx, const std::filesystem::path& fullpath, size_t offset, size_t length) noexcept;
+    Result<Context> createIndex(Context&& ctx, const Index& index) noexcept;
+    Result<Context> keepManifests(Context&& ctx) noexcept;
+    Result<Context> keepPathFilters(Context&& ctx) noexcept;
+    Result<Context> keepCommitIndex(Context&& ctx) noexcept;
+    Result<Context> serializable(Context&& ctx) noexcept;
   }
 
+  /// @brief Lazily lists a directory, committed entries merged with the context's uncommitted updates
+  /// @param ctx The context whose tip and updates are listed, the context isn't required to outlive the generator
+  /// @param dir The directory to list, an empty path for the root directory
+  /// @return A generator of entries, committed entries (in git order) followed by newly introduced ones.
+  ///         On failure a single Error is yielded.
+  ///
+  /// NOTE: A directory with uncommitted updates below it, still carries the oid of its last commit
+  Generator<Result<Entry>>
+  entries(const Context& ctx, const std::filesystem::path& dir) noexcept;
+
+  /// @brief Describes a file or directory from its tree entry and object header, without loading its content
+  /// @param ctx The context, its uncommitted updates take precedence over its tip
+  /// @param fullpath The full path of the file or directory, an empty path for the root directory
+  /// @return On success the entry (name, type, oid, mode, size), otherwise an Error (NotFound, or Deleted if
+  ///         removed by an uncommitted update)
+  Result<Entry>
+  stat(const Context& ctx, const std::filesystem::path& fullpath) noexcept;
+
+  /// @brief Tests whether a file or directory exists, see `stat`
+  /// @return On success True if found, False if not found or deleted by an uncommitted update, otherwise an Error
+  Result<bool>
+  exists(const Context& ctx, const std::filesystem::path& fullpath) noexcept;
+
+  /// @brief Tree walk order, a directory is visited either before (pre) or after (post) its content
+  enum class WalkOrder { PreOrder, PostOrder };
+
+  struct WalkOptions {
+    WalkOrder order_    = WalkOrder::PreOrder;
+    size_t    maxDepth_ = std::numeric_limits<size_t>::max(); /* 1 walks only the direct entries of the prefix */
+  };
+
+  /// @brief An item visited by a tree walk, content is loaded only on demand
+  struct WalkItem {
+    std::filesystem::path path_;  /* Full path of the item, including the walked prefix */
+    git_oid               oid_;   /* Object id of the blob or tree                       */
+    git_filemode_t        mode_;  /* Entry's file mode                                   */
+    git_repository*       repo_;  /* The repository the item belongs to                  */
+
+    bool isDir() const noexcept { return mode_ == GIT_FILEMODE_TREE; }
+
+    /// @brief Loads the item's content
+    /// @return On success the blob's content, otherwise an Error (i.e. for directories)
+    Result<std::string> content() const noexcept;
+  };
+
+  /// @brief Lazily and recursively walks the committed tree under a prefix, from the context's tip
+  /// @param ctx The context whose tip is walked, the context isn't required to outlive the generator
+  /// @param prefix The directory to walk, an empty path to walk the entire tree
+  /// @param opts The walk order and depth limit
+  /// @return A generator of items in git order, depth first. On failure an Error is yielded and the walk stops.
+  ///
+  /// NOTE: Uncommitted updates are not walked
+  Generator<Result<WalkItem>>
+  walk(const Context& ctx, const std::filesystem::path& prefix = {}, WalkOptions opts = {}) noexcept;
+
+  /// @brief Resumes a scan right after the last key of a page, on the root tree the scan started on
+  struct ScanCursor {
+    git_oid     root_;   /* The scanned root tree, later commits don't affect the scan */
+    std::string after_;  /* The last key returned                                       */
+
+    /// @brief A printable form of the cursor, i.e. to be handed to a client
+    std::string token() const noexcept;
+
+    /// @brief Parses a cursor's printable form
+    /// @return On success the cursor, otherwise an Error (i.e. a malformed token)
+    static Result<ScanCursor> fromToken(const std::string& token) noexcept;
+  };
+
+  /// @brief A page of scanned files and the cursor of the next page
+  struct ScanPage {
+    std::vector<WalkItem>     items_; /* Files, in lexicographic order of their full path        */
+    std::optional<ScanCursor> next_;  /* Resumes the scan, empty when the range is exhausted     */
+  };
+
+  /// @brief Lists the committed files whose full path (i.e. "docs/a/1") is in [start, end), in lexicographic
+  ///        order across nested directories. Directories entirely out of the range are skipped unread.
+  /// @param ctx The context whose tip is scanned
+  /// @param start The first key in range, an empty key starts at the first file
+  /// @param end The first key out of range, an empty key scans to the last file
+  /// @param limit Maximal number of files in a page, at least one
+  /// @return On success a page of files and the cursor of the next page, otherwise an Error
+  ///
+  /// NOTE: Uncommitted updates are not scanned
+  Result<ScanPage>
+  scan(const Context& ctx, const std::string& start, const std::string& end = {}, size_t limit = 1000) noexcept;
+
+  /// @brief Continues a scan from a cursor, see `scan`. The cursor's root tree is scanned, not the context's tip.
+  Result<ScanPage>
+  scan(const Context& ctx, const ScanCursor& from, const std::string& end = {}, size_t limit = 1000) noexcept;
+
+  /// @brief The syntax of a `find` pattern
+  ///  - Glob: matched per path segment, '*' and '?' don't cross a '/', '**' spans any number of directories
+  ///          and '[...]' is a character class (negated by a leading '!' or '^')
+  ///  - Regex: an ECMAScript regular expression, matching the entire full path
+  enum class PatternKind { Glob, Regex };
+
+  /// @brief Lazily finds the files whose full path (i.e. "docs/a/1.md") matches a pattern.
+  ///        A directory is descended into only if the pattern may match below it, i.e. "docs/*/1.md"
+  ///        never reads "src", and a regex is pruned by its literal prefix.
+  /// @param ctx The context whose tip and updates are searched, the context isn't required to outlive the generator
+  /// @param pattern A glob or regular expression, see `PatternKind`
+  /// @param kind The pattern's syntax
+  /// @return A generator of files, directory by directory: a directory's files before its subdirectories.
+  ///         On failure (i.e. a malformed regex) an Error is yielded and the search stops.
+  ///
+  /// NOTE: Uncommitted updates take precedence over the tip, as with `entries`
+  Generator<Result<WalkItem>>
+  find(const Context& ctx, const std::string& pattern, PatternKind kind = PatternKind::Glob) noexcept;
+
+  /// @brief Finds the files indexed under a key, see `createIndex`
+  /// @param ctx The context whose tip is searched
+  /// @param index The index name
+  /// @param key The key to look up
+  /// @return On success the files (path and blob) holding the key, possibly none, otherwise an Error
+  ///
+  /// NOTE: Only committed files are found, the index is maintained on commit
+  Result<std::vector<WalkItem>>
+  lookup(const Context& ctx, const std::string& index, const std::string& key) noexcept;
+
+  /// @brief A version of a file, the commit introducing it and its content's blob
+  struct Version {
+    git_oid                               commit_;  /* The commit introducing the version */
+    git_oid                               blob_;    /* The file's content at that commit  */
+    std::string                           author_;  /* Commit's author name               */
+    std::string                           email_;   /* Commit's author email              */
+    std::chrono::system_clock::time_point time_;    /* Commit time                        */
+  };
+
+  struct HistoryOptions {
+    size_t limit_ = std::numeric_limits<size_t>::max();        /* Maximal number of versions   */
+    std::optional<std::chrono::system_clock::time_point> since_; /* Only versions committed at or after  */
+    std::optional<std::chrono::system_clock::time_point> until_; /* Only versions committed at or before */
+  };
+
+  /// @brief Lazily lists the versions of a file, newest first, from the context's tip
+  /// @param ctx The context whose tip history is searched, the context isn't required to outlive the generator
+  /// @param fullpath The fullpath of the file in the repository
+  /// @param opts Limits on the number and times of versions
+  /// @return A generator of versions, a commit is a version only if the file differs from all its parents.
+  ///         On failure an Error is yielded and the search stops.
+  ///
+  /// Commits are compared along the file's directory chain only, so a commit is skipped as soon
+  /// as a directory on the chain is unchanged (same oid), without descending into it.
+  /// Commits whose changed-path filter excludes the file are skipped without reading their trees.
+  Generator<Result<Version>>
+  history(const Context& ctx, const std::filesystem::path& fullpath, HistoryOptions opts = {}) noexcept;
+
+  /// @brief Tests whether any commit since a revision changed a file or directory, or anything under it
+  /// @param ctx The context whose tip history is searched
+  /// @param since The revision, its own changes aren't included, see `readAt` for revision resolution
+  /// @param fullpath The path, an empty path for the entire tree
+  /// @return On success True if a commit reachable from the tip but not from `since` changed the path,
+  ///         otherwise an Error
+  ///
+  /// A change later reverted is still a change. Commits whose changed-path filter excludes the path are
+  /// skipped without reading their trees. Uncommitted updates aren't considered.
+  Result<bool>
+  changedSince(const Context& ctx, const Revision& since, const std::filesystem::path& fullpath = {}) noexcept;
+
+  enum class ChangeType { Added, Modified, Deleted, Renamed };
+
+  /// @brief A file changed between two revisions
+  struct Change {
+    ChangeType            type_;    /* Kind of change                                         */
+    std::filesystem::path path_;    /* Full path on the `to` revision (on `from` when deleted) */
+    std::filesystem::path from_;    /* Full path on the `from` revision, differs on renames   */
+    git_oid               oldOid_;  /* Blob on `from`, zero when added                        */
+    git_oid               newOid_;  /* Blob on `to`, zero when deleted                        */
+    git_filemode_t        mode_;    /* File mode on `to` (on `from` when deleted)              */
+  };
+
+  /// @brief Lazily compares the files of two revisions, under a prefix
+  /// @param ctx The context used to access the repository, it isn't required to outlive the generator
+  /// @param from The base revision
+  /// @param to The compared revision
+  /// @param prefix The directory to compare, an empty path to compare the entire tree
+  /// @return A generator of changes. Modifications are yielded as found, while added and deleted files
+  ///         are paired into exact (same blob) renames and yielded once the comparison is done.
+  ///         On failure an Error is yielded and the comparison stops.
+  ///
+  /// Identical subtrees (same oid) are skipped without loading them, so the cost is proportional
+  /// to the change, not to the size of the repository.
+  Generator<Result<Change>>
+  diff(const Context& ctx, const Revision& from, const Revision& to, const std::filesystem::path& prefix = {}) noexcept;
+
+  /**
+   * An immutable read only view of one commit, that can be shared by many threads
+   *
+   * Unlike a Context, a Snapshot is cheap to copy (copies share state), holds no uncommitted updates and
+   * never moves, all reads through it see the same commit. The root tree and the directory trees visited
+   * by reads are loaded once and shared by all copies, for the lifetime of the last copy.
+   **/
+  class Snapshot {
+    public:
+    struct State;
+
+    explicit Snapshot(std::shared_ptr<const State> state) noexcept
+    : state_{ std::move(state) } {}
+
+    const git_oid& commitId() const noexcept;
+    const git_oid& rootId() const noexcept;
+
+    /// @brief Reads a file's content
+    /// @param fullpath The fullpath of the file in the repository
+    /// @return On success the file's content, otherwise an Error
+    Result<std::string> read(const std::filesystem::path& fullpath) const noexcept;
+
+    /// @brief Describes a file or directory without loading its content, see `gd::stat`
+    Result<Entry> stat(const std::filesystem::path& fullpath) const noexcept;
+
+    /// @brief Lazily lists a directory, see `gd::entries`
+    Generator<Result<Entry>> entries(const std::filesystem::path& dir) const noexcept;
+
+    /// @brief Lazily walks the tree under a prefix, see `gd::walk`
+    Generator<Result<WalkItem>> walk(const std::filesystem::path& prefix = {}, WalkOptions opts = {}) const noexcept;
+
+    private:
+    std::shared_ptr<const State> state_;
+  };
+
+  /// @brief Takes a snapshot of the context's tip, uncommitted updates are not part of the snapshot
+  /// @param ctx The context, it isn't required to outlive the snapshot
+  /// @return On success the Snapshot, otherwise an Error (i.e. nothing was committed yet)
+  Result<Snapshot>
+  snapshot(const Context& ctx) noexcept;
+
+  /// @brief Takes a snapshot of a given revision, see `readAt` for revision resolution
+  Result<Snapshot>
+  snapshot(const Context& ctx, const Revision& rev) noexcept;
+
+  /// @brief A subtree to be loaded into the repository's caches ahead of use
+  struct Prefetch {
+    std::filesystem::path prefix_;                                      /* Subtree to load, empty for the entire tree */
+    size_t                depth_        = std::numeric_limits<size_t>::max(); /* Directory levels to load           */
+    bool                  includeBlobs_ = false;                        /* Load files too, not only directories       */
+  };
+
+  /// @brief Loads a subtree of the context's tip, in the background, so later reads find it in libgit2's
+  ///        object cache (and its pack data in memory) rather than inflating it on demand
+  /// @param ctx The context whose tip is loaded, the context isn't required to outlive the prefetch
+  /// @param what The subtree, depth and whether blobs are loaded as well as trees
+  /// @return A future of the number of objects loaded, or of an Error
+  ///
+  /// NOTE: Which objects remain cached is bound by libgit2's cache size and per type object limits
+  /// NOTE: The future is of `std::async`, its destructor waits for the prefetch; a dropped future makes the
+  ///       prefetch synchronous, keep it while the prefetch is meant to run in the background
+  [[nodiscard]] std::future<Result<size_t>>
+  prefetch(const Context& ctx, Prefetch what) noexcept;
+
+  /// @brief Predefined tunings of libgit2, see `RepositoryOptions::of`
+  enum class Profile {
+    Default,    /* libgit2's own defaults                                                    */
+    ReadHeavy,  /* Large object cache that keeps trees, commits and small blobs, wide pack mapping */
+    WriteHeavy, /* Small cache, no existence checks of referenced objects on creation         */
+    LowMemory,  /* Small cache and narrow pack mapping                                        */
+    Durable     /* libgit2's defaults with fsync of objects and refs                         */
+  };
+
+  /// @brief Tuning of libgit2's caches and object database, unset fields are left as they are
+  ///
+  /// NOTE: libgit2 settings are process wide, they apply to every repository and not only to the selected one
+  struct RepositoryOptions {
+    std::optional<ssize_t> cacheMaxSize_;         /* Bytes of decoded objects kept in the object cache     */
+    std::optional<size_t>  commitCacheLimit_;     /* Largest commit cached, 0 never caches commits         */
+    std::optional<size_t>  treeCacheLimit_;       /* Largest tree cached, 0 never caches trees             */
+    std::optional<size_t>  blobCacheLimit_;       /* Largest blob cached, 0 never caches blobs             */
+    std::optional<size_t>  mwindowSize_;          /* Bytes of pack data mapped per window                  */
+    std::optional<size_t>  mwindowMappedLimit_;   /* Bytes of pack data mapped at once, over all packs     */
+    std::optional<bool>    strictObjectCreation_; /* Verify that referenced objects exist when creating one */
+    std::optional<bool>    fsync_;                /* fsync objects and refs when written                   */
+    std::optional<bool>    verifyHashes_;         /* Verify objects' hashes when read                       */
+    std::vector<Prefetch>  warmUp_;               /* Subtrees to prefetch on selection, see `prefetch`     */
+
+    /// @brief The options of a predefined profile
+    static RepositoryOptions of(Profile profile) noexcept;
+  };
+
+  /// @brief Applies libgit2 tuning
+  /// @param options The settings to apply, unset fields are left as they are
+  /// @return On success the effective settings (all fields set), otherwise an Error, the settings are then
+  ///         restored to the ones before the call
+  Result<RepositoryOptions>
+  tune(const RepositoryOptions& options) noexcept;
+
+  /// @brief The effective libgit2 tuning, all fields set
+  RepositoryOptions
+  tuning() noexcept;
+
+  /// @brief Called after every successful commit to a repository, with the committing context at its new tip
+  using CommitObserver = std::function<void(const Context& ctx)>;
+
+  /// @brief Registers an observer of the commits to the context's repository, on any branch
+  /// @param ctx The context whose repository is observed
+  /// @param observer Called synchronously by the committing thread, once the commit is published. Mustn't throw.
+  /// @return On success an id to remove the observer with, otherwise an Error
+  Result<size_t>
+  observeCommits(const Context& ctx, CommitObserver observer) noexcept;
+
+  /// @brief Removes a commit observer, see `observeCommits`
+  void
+  removeObserver(size_t id) noexcept;
+
   /// @brief Sets a user spdLog::Logger to accomodate for application needs
   /// @param newLogger The new spdlog::Logger
   /// @return the old logger
@@ -175,6 +529,28 @@ namespace gd
   Result<Context>
   selectRepository(const std::filesystem::path& fullpath, const std::string& name = "") noexcept;
 
+  /// @brief Opens or creates a repository, and warms its caches before returning the context
+  /// @param fullpath Fullpath to the repository
+  /// @param warmUp Subtrees of the repository's HEAD to prefetch (concurrently), see `prefetch`
+  /// @param name creator's name, in case of creation the repository's creator will be 'name'. [Optional]
+  /// @return On success, a context to work with repository, otherwise an Error
+  ///
+  /// NOTE: Warm up is best effort, failures (i.e. missing prefixes) are logged and don't fail the selection
+  Result<Context>
+  selectRepository(const std::filesystem::path& fullpath, const std::vector<Prefetch>& warmUp, const std::string& name = "") noexcept;
+
+  /// @brief Tunes libgit2, then opens or creates a repository and warms its caches, see `tune`
+  /// @param fullpath Fullpath to the repository
+  /// @param options The tuning to apply and the subtrees to prefetch
+  /// @param name creator's name, in case of creation the repository's creator will be 'name'. [Optional]
+  /// @return On success, a context to work with repository, otherwise an Error (i.e. tuning was rejected)
+  Result<Context>
+  selectRepository(const std::filesystem::path& fullpath, const RepositoryOptions& options, const std::string& name = "") noexcept;
+
+  /// @brief Tunes libgit2 with a predefined profile, then opens or creates a repository
+  Result<Context>
+  selectRepository(const std::filesystem::path& fullpath, Profile profile, const std::string& name = "") noexcept;
+
   /// @brief selects a differen branch
   /// @param name the name of the branch to move to
   /// @return On success returns a context for continuation, otherwise an Error
@@ -196,6 +572,17 @@ namespace gd
     };
   }
 
+  /// @brief Adds a file by linking a blob already in the repository, the content isn't transferred nor rehashed
+  /// @param fullpath the fullpath including the file name
+  /// @param blobId The blob's `git_oid` (i.e. from `stat`, or an `Entry`)
+  /// @return On success returns a context for continuation, otherwise an Error (i.e. unknown blob)
+  inline auto addById(const std::filesystem::path& fullpath, const git_oid& blobId) noexcept
+  {
+    return [&fullpath, &blobId](Context&& ctx) -> Result<Context> {
+      return ni::addById(std::move(ctx), fullpath, blobId);
+    };
+  }
+
   /// @brief Removes a file or a directory by fullpath
   /// @param fullpath The full path of the file to remove
   /// @return On success returns a context for continuation, otherwise an Error
@@ -320,6 +707,103 @@ namespace gd
     };
   }
 
+  /// @brief Reads a file(blob)'s contents as it was at a given revision, the context's tip and updates are unaffected
+  /// @param fullpath The fullpath of the file in the repository
+  /// @param rev A revision string, a commit id, or a point in time (the latest commit of the context's branch at that time)
+  /// @return On success a ReadContext holding the content, otherwise an Error
+  inline auto readAt(const std::filesystem::path& fullpath, const Revision& rev) noexcept
+  {
+    return [&fullpath, &rev](Context&& ctx) -> Result<ReadContext> {
+      return ni::readAt(std::move(ctx), fullpath, rev);
+    };
+  }
+
+  /// @brief Reads a blob's content by its id, without a path nor a commit
+  /// @param blobId The blob's `git_oid`
+  /// @return On success a ReadContext holding the content, otherwise an Error
+  inline auto readById(const git_oid& blobId) noexcept
+  {
+    return [&blobId](Context&& ctx) -> Result<ReadContext> {
+      return ni::readById(std::move(ctx), blobId);
+    };
+  }
+
+  /// @brief Reads a byte range of a file(blob), without loading the entire file where possible
+  /// @param fullpath The fullpath of the file in the repository
+  /// @param offset The first byte to read, reading past the file's end yields an empty content
+  /// @param length Maximum number of bytes to read
+  /// @return On success a ReadContext holding the bytes in range, otherwise an Error
+  ///
+  /// NOTE: The range is of the raw content, filters applied by `read` (i.e. line endings) aren't
+  inline auto readRange(const std::filesystem::path& fullpath, size_t offset, size_t length) noexcept
+  {
+    return [&fullpath, offset, length](Context&& ctx) -> Result<ReadContext> {
+      return ni::readRange(std::move(ctx), fullpath, offset, length);
+    };
+  }
+
+  /// @brief Registers a secondary index, maintained by every later commit to the repository (on any branch)
+  ///        An index not yet stored at the context's tip is built from the tip's files, as part of the next commit
+  /// @param index The index definition, registration lasts for the process lifetime
+  /// @return On success the context, holding the initial entries as updates, otherwise an Error
+  inline auto createIndex(const Index& index) noexcept
+  {
+    return [&index](Context&& ctx) -> Result<Context> {
+      return ni::createIndex(std::move(ctx), index);
+    };
+  }
+
+  /// @brief Keeps a flat manifest of every later commit to the repository (on any branch), see `Manifest`
+  /// @return On success the context, registration lasts for the process lifetime, otherwise an Error
+  inline auto keepManifests() noexcept
+  {
+    return [](Context&& ctx) -> Result<Context> {
+      return ni::keepManifests(std::move(ctx));
+    };
+  }
+
+  /// @brief Keeps a changed-path Bloom filter of every later commit to the repository, see `PathFilters`
+  /// @return On success the context, registration lasts for the process lifetime, otherwise an Error
+  inline auto keepPathFilters() noexcept
+  {
+    return [](Context&& ctx) -> Result<Context> {
+      return ni::keepPathFilters(std::move(ctx));
+    };
+  }
+
+  /// @brief Keeps the metadata (author, time, ref, message terms) of every later commit to the repository, see `CommitIndex`
+  /// @return On success the context, registration lasts for the process lifetime, otherwise an Error
+  inline auto keepCommitIndex() noexcept
+  {
+    return [](Context&& ctx) -> Result<Context> {
+      return ni::keepCommitIndex(std::move(ctx));
+    };
+  }
+
+  /// @brief Makes the context's transactions serializable: files read are recorded, and validated by the commit
+  /// @return On success the context, otherwise an Error
+  ///
+  /// A commit fails with a `Conflict` when a file read or updated (i.e. patched) changed on the tip since, otherwise it's committed on top
+  /// of the tip even if the tip moved since the reads. The reads are forgotten by each commit and rollback.
+  inline auto serializable() noexcept
+  {
+    return [](Context&& ctx) -> Result<Context> {
+      return ni::serializable(std::move(ctx));
+    };
+  }
+
+  /// @brief Lists a directory's entries (name, type, oid, size) without loading any blob
+  /// @param dir The fullpath of the directory in the repository, an empty path for the root directory
+  /// @return On success a ListContext holding the entries, otherwise an Error
+  ///
+  /// For large directories prefer the lazy `entries(ctx, dir)`
+  inline auto list(const std::filesystem::path& dir) noexcept
+  {
+    return [&dir](Context&& ctx) -> Result<ListContext> {
+      return ni::list(std::move(ctx), dir);
+    };
+  }
+
   /// @brief Access support command chaining via the expect primitives of and_then/or_else
   /// shorthand replaces them with the operators >> and || for increased readablity
   namespace shorthand {
@@ -351,12 +835,36 @@ namespace gd
      * db >> addFile(...);
      * db >> rollback();
      *
+     * Each of the above starts afresh from the tip, a session keeps the context (tip and updates) between calls
+     * db.begin();
+     * db >> addFile(...);
+     * db >> read(...);     // Reads the uncommitted file, the session carries on
+     * db >> commit(...);
+     * db.end();
+     *
+     * A failed operation leaves the session failed (as a failed chain), until it's begun again.
+     * The session is per thread, and it stays on its repository and branch until it ends.
      ***/
-    class ThreadChainingContext {};
-    static ThreadChainingContext db;
+    class ThreadChainingContext {
+      public:
+      /// @brief Begins the thread's session at the tip of the thread's repository/ref, dropping an ongoing one
+      /// @return On success nothing, otherwise an Error (i.e. no repository selected)
+      Result<void> begin() const noexcept;
+
+      /// @brief Ends the thread's session, its uncommitted updates are dropped
+      void end() const noexcept;
+    };
+    inline ThreadChainingContext db;
 
     Result<Context> getThreadContext() noexcept;
 
+    /// @brief The thread's session, or a fresh thread context when no session was begun
+    Result<Context>& threadSession() noexcept;
+
+    /// @brief Carries the thread's session on from a context, its tip, updates and reads are moved back to
+    ///        the session, the context keeps its repository and branch
+    void resumeSession(Context& ctx) noexcept;
+
     /**
      * Support for call chaining, 
      *   >>  on successful execution (and_then)
@@ -389,23 +897,6 @@ namespace gd
      *  This can only happen when the Return type `L` is the same as the LValue.
      **/
 
-    /**
-     * RValue chaining for operator >> (and_then)
-     */
-    template <typename F>
-    auto operator >>(ThreadChainingContext, F&& f)
-    {
-      return std::move(getThreadContext()).and_then(std::forward<F>(f));
-    }
-
-    /**
-     * RValue chaining for operator || (or_else)
-     */
-    template <typename F>
-    auto operator ||(ThreadChainingContext, F&& f)
-    {
-      return std::move(getThreadContext()).or_else(std::forward<F>(f));
-    }
 
     /**
      * LValue handling for >> (and_then) when the LValue type == L
@@ -473,6 +964,37 @@ namespace gd
       return std::move(lhs).or_else(std::forward<F>(f));
     }
 
+    /**
+     * Chaining for operator >> (and_then) on the thread's session, as a LValue
+     *
+     * An operation returning a derived context (i.e. read) returns its content, repository and branch, the
+     * session carries on with the rest of its context (tip, updates and reads). A failed operation leaves its
+     * Error in the session.
+     */
+    template <typename F>
+    decltype(auto) operator >>(ThreadChainingContext, F&& f)
+    {
+      auto& session = threadSession();
+      if constexpr (std::is_reference_v<decltype(session >> std::forward<F>(f))>) {
+        return session >> std::forward<F>(f);
+      } else {
+        auto result = session >> std::forward<F>(f);
+        if (!result)
+          session = std::unexpected(result.error());
+        else if constexpr (std::is_base_of_v<Context, typename decltype(result)::value_type>)
+          resumeSession(*result);
+        return result;
+      }
+    }
+
+    /**
+     * Chaining for operator || (or_else) on the thread's session, as a LValue
+     */
+    template <typename F>
+    decltype(auto) operator ||(ThreadChainingContext, F&& f)
+    {
+      return threadSession() || std::forward<F>(f);
+    }
   }
 };
 
@@ -0,0 +1,53 @@
+#pragma once
+#include <gd/gd.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Content search of the files of a revision, i.e. "which documents contain X at revision R".
+ *
+ * The tree walk is shared by a pool of worker threads:
+ *  - A directory is a unit of work, reading it queues its subdirectories and its files, in batches
+ *  - Blobs are inflated and searched by the workers, in parallel
+ *  - Patterns are matched by a vectorized kernel (AVX2 or SSE2 on x86-64, scalar otherwise),
+ *    filtering candidates by the pattern's first and last bytes before comparing them
+ *
+ * Matches stream back as they are found, per file in offset order, while files are in no particular order.
+ **/
+namespace gd
+{
+  struct GrepOptions {
+    size_t threads_     = 0;    /* Worker threads, 0 for the hardware concurrency                   */
+    size_t batch_       = 64;   /* Files per unit of work                                           */
+    size_t maxPending_  = 4096; /* Matches buffered before the workers wait for the consumer        */
+  };
+
+  /// @brief An occurrence of a pattern in a file
+  struct GrepMatch {
+    std::filesystem::path path_;    /* Full path of the file                    */
+    size_t                offset_;  /* Byte offset of the occurrence in the file */
+    size_t                pattern_; /* Index of the pattern found               */
+  };
+
+  /// @brief Lazily finds every occurrence of any of the patterns, in the files of a revision under a prefix
+  /// @param ctx The context used to access the repository, it isn't required to outlive the generator
+  /// @param rev The revision searched, see `readAt` for revision resolution
+  /// @param patterns The literal (byte string) patterns, i.e. {"needle"}. Empty patterns are never found
+  /// @param prefix The directory searched, an empty path for the entire tree
+  /// @param opts Worker threads and buffering
+  /// @return A generator of matches. On failure an Error is yielded and the search stops.
+  ///
+  /// NOTE: Workers are stopped and joined when the generator is destroyed, even if it isn't exhausted
+  Generator<Result<GrepMatch>>
+  grep(const Context& ctx, const Revision& rev, std::vector<std::string> patterns,
+       const std::filesystem::path& prefix = {}, GrepOptions opts = {}) noexcept;
+
+  /// @brief Finds every (possibly overlapping) occurrence of `needle` in `haystack`, using the grep kernel
+  /// @return The occurrences' offsets, ascending
+  std::vector<size_t> occurrences(std::string_view haystack, std::string_view needle) noexcept;
+
+  /// @brief The kernel selected for this CPU: "avx2", "sse2" or "scalar"
+  const char* grepKernel() noexcept;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <gd/gd.h>
+
+#include <string>
+#include <string_view>
+
+/**
+ * Structured (JSON) documents, a field is read or updated by its JSON pointer (RFC 6901), i.e. "/author/name" or "/tags/0"
+ *
+ * A field is found by a single pass tokenizer, values before it are skipped rather than parsed and no DOM is built:
+ *  - The members passed on the way are remembered per blob oid, blobs being immutable a later read of any of them
+ *    is a lookup
+ *  - An update splices the new value into the document's bytes, the rest of the document is kept as is
+ *
+ * Values are raw JSON text, i.e. `"Steven"` (with its quotes), `42` or `{"born": 1954}`.
+ **/
+namespace gd
+{
+  /// @brief Finds a field of a JSON document
+  /// @param doc The document
+  /// @param pointer The field's JSON pointer, an empty pointer for the entire document
+  /// @return On success the field's value, a view of `doc`, otherwise an Error
+  ///         (NotFound, BadFile for a malformed document, Application for a malformed pointer)
+  Result<std::string_view> jsonField(std::string_view doc, std::string_view pointer) noexcept;
+
+  /// @brief Replaces a field of a JSON document, or adds it to its object (or to its array by the "-" index)
+  /// @param doc The document
+  /// @param pointer The field's JSON pointer, an empty pointer for the entire document
+  /// @param value The field's new value, raw JSON text
+  /// @return On success the updated document, otherwise an Error, see `jsonField`
+  Result<std::string> jsonPatch(std::string_view doc, std::string_view pointer, std::string_view value) noexcept;
+
+  namespace ni {
+    Result<ReadContext> readField(Context&& ctx, const std::filesystem::path& fullpath, std::string_view pointer) noexcept;
+    Result<Context> patchField(Context&& ctx, const std::filesystem::path& fullpath, std::string_view pointer,
+                               std::string_view value) noexcept;
+  }
+
+  /// @brief Reads a field of a JSON file, uncommitted updates included
+  /// @param fullpath The fullpath of the file in the repository
+  /// @param pointer The field's JSON pointer
+  /// @return On success a ReadContext holding the field's value, otherwise an Error
+  inline auto readField(const std::filesystem::path& fullpath, std::string_view pointer) noexcept
+  {
+    return [&fullpath, pointer](Context&& ctx) -> Result<ReadContext> {
+      return ni::readField(std::move(ctx), fullpath, pointer);
+    };
+  }
+
+  /// @brief Updates a field of a JSON file, the updated file is collected like `add`
+  /// @param fullpath The fullpath of the file in the repository
+  /// @param pointer The field's JSON pointer, see `jsonPatch`
+  /// @param value The field's new value, raw JSON text
+  /// @return On success the context, otherwise an Error
+  inline auto patchField(const std::filesystem::path& fullpath, std::string_view pointer, std::string_view value) noexcept
+  {
+    return [&fullpath, pointer, value](Context&& ctx) -> Result<Context> {
+      return ni::patchField(std::move(ctx), fullpath, pointer, value);
+    };
+  }
+}
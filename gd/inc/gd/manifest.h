@@ -0,0 +1,82 @@
+#pragma once
+#include <gd/gd.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * A flat manifest of a commit's files, kept next to the repository's objects in `<repository>/gd-manifest/<hex commit>`.
+ *
+ * The manifest is a sorted array of (full path hash, path, blob oid, mode), memory mapped when opened:
+ *  - A file is found by a single binary search, instead of walking its nested trees
+ *  - Two manifests are compared by a linear merge of their arrays, instead of recursing both trees
+ *
+ * Manifests are optional, written by `ni::commit` once `keepManifests` was called for the repository.
+ * A commit's manifest is built from its parent's manifest and the commit's updates, only the updated
+ * paths are read from the new tree. Without a parent manifest (i.e. the first one) the entire tree is read.
+ *
+ * File layout: a header (magic, record count, commit id), the records ordered by (hash, path), then the paths.
+ **/
+namespace gd
+{
+  class Manifest {
+    public:
+
+    /// @brief A file of the manifest, its path is a view of the mapped manifest
+    struct Item {
+      std::string_view path_;  /* Full path of the file */
+      git_oid          oid_;   /* The file's blob        */
+      git_filemode_t   mode_;  /* The file's mode        */
+    };
+
+    struct Mapping;
+
+    /// @brief Opens the manifest of the context's tip
+    /// @return On success the manifest, otherwise an Error (NotFound when the tip has no manifest)
+    static Result<Manifest> open(const Context& ctx) noexcept;
+
+    /// @brief Opens the manifest of a revision, see `readAt` for revision resolution
+    static Result<Manifest> open(const Context& ctx, const Revision& rev) noexcept;
+
+    /// @brief Finds a file by a binary search
+    /// @return On success the file, otherwise an Error (NotFound)
+    Result<Item> find(const std::filesystem::path& fullpath) const noexcept;
+
+    /// @brief The number of files
+    size_t size() const noexcept;
+
+    /// @brief A file by its position, in (hash, path) order
+    Item operator[](size_t pos) const noexcept;
+
+    /// @brief The commit the manifest describes
+    const git_oid& commitId() const noexcept;
+
+    private:
+    friend std::vector<Change> diff(const Manifest& from, const Manifest& to) noexcept;
+
+    explicit Manifest(std::shared_ptr<const Mapping> mapping) noexcept
+    : mapping_{ std::move(mapping) } {}
+
+    std::shared_ptr<const Mapping> mapping_;
+  };
+
+  /// @brief Compares the files of two manifests by a linear merge
+  /// @return The changes, Added, Modified or Deleted (renames aren't detected), in (hash, path) order
+  std::vector<Change>
+  diff(const Manifest& from, const Manifest& to) noexcept;
+
+  namespace internal {
+    /// @brief Writes the manifest of a new commit, see above
+    /// @param repo The repository
+    /// @param parentId The commit's parent, nullptr for a root commit
+    /// @param commitId The new commit
+    /// @param root The new commit's root tree
+    /// @param changed The paths updated by the commit (files or directories)
+    /// @return On success nothing, otherwise an Error
+    Result<void> writeManifest(git_repository* repo, git_oid const* parentId, const git_oid& commitId,
+                               const git_tree* root, const std::vector<std::filesystem::path>& changed) noexcept;
+  }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <gd/gd.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * Changed-path Bloom filters, a filter per commit of the paths it changed, kept next to the repository's
+ * objects in a single append only file `<repository>/gd-path-filters` (like git's commit-graph changed-path filters).
+ *
+ * A commit's filter holds, for every path updated by the commit (file or directory):
+ *  - The path and each of its parent directories, i.e. "a/b/c", "a/b" and "a"
+ *  - The path as a subtree, i.e. "a/b/c/", since an updated directory (moved, removed) changes all of its files
+ *
+ * The filter answers "may the commit have changed anything at or under X" without reading the commit's trees,
+ * false positives are possible (about 1%), false negatives aren't. A commit without a filter (i.e. committed
+ * before `keepPathFilters`, or by another tool) is always a "may have".
+ *
+ * Filters are written by `ni::commit` once `keepPathFilters` was called for the repository, from the
+ * commit's collected updates, and are compared to the commit's first parent.
+ **/
+namespace gd
+{
+  struct PathFilterTable;
+  class PathFilters;
+
+  namespace internal {
+    Result<PathFilters> currentPathFilters(git_repository* repo) noexcept;
+  }
+
+  /// @brief The Bloom filter of a commit, a view valid as long as its `PathFilters`
+  class PathFilter {
+    public:
+
+    /// @brief Tests whether the commit may have changed a file or directory, or anything under it
+    /// @param fullpath The path, an empty path for the entire tree
+    /// @return False only if the commit surely didn't change the path
+    bool mayHaveChanged(const std::filesystem::path& fullpath) const noexcept;
+
+    private:
+    friend class PathFilters;
+
+    PathFilter(uint64_t const * words, size_t count) noexcept
+    : words_{ words }, count_{ count } {}
+
+    uint64_t const * words_;
+    size_t           count_;  /* Of words, 0 when the commit changed too many paths to filter */
+  };
+
+  /// @brief A snapshot of a repository's filters, later commits' filters aren't seen
+  class PathFilters {
+    public:
+
+    /// @brief Loads the filters of the context's repository, reading only filters appended since the last load
+    /// @return On success the filters, possibly none, otherwise an Error
+    static Result<PathFilters> open(const Context& ctx) noexcept;
+
+    /// @brief The filter of a commit
+    /// @return The filter, or nullopt if the commit has none
+    std::optional<PathFilter> find(const git_oid& commitId) const noexcept;
+
+    /// @brief Tests whether a commit may have changed a path, see `PathFilter::mayHaveChanged`
+    /// @return True if the commit has no filter
+    bool mayHaveChanged(const git_oid& commitId, const std::filesystem::path& fullpath) const noexcept;
+
+    /// @brief The number of commits with a filter
+    size_t size() const noexcept;
+
+    private:
+    friend Result<PathFilters> internal::currentPathFilters(git_repository* repo) noexcept;
+
+    explicit PathFilters(std::shared_ptr<const PathFilterTable> table) noexcept
+    : table_{ std::move(table) } {}
+
+    std::shared_ptr<const PathFilterTable> table_;
+  };
+
+  namespace internal {
+    /// @brief Appends the filter of a new commit, see above
+    /// @param repo The repository
+    /// @param commitId The new commit
+    /// @param changed The paths updated by the commit (files or directories)
+    /// @return On success nothing, otherwise an Error
+    Result<void> writePathFilter(git_repository* repo, const git_oid& commitId,
+                                 const std::vector<std::filesystem::path>& changed) noexcept;
+
+    /// @brief The filters of a repository as last loaded, reloaded only after this process appended a filter
+    ///        Filters appended by other processes aren't seen, their commits are "may have"
+    /// @return On success the filters, possibly none, otherwise an Error
+    Result<PathFilters> currentPathFilters(git_repository* repo) noexcept;
+
+    /// @brief Forgets the loaded filters of a repository, i.e. when it's removed
+    void dropPathFilters(git_repository* repo) noexcept;
+  }
+}
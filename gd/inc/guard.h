@@ -89,6 +89,10 @@ namespace gd {
   using signature_t   = Guard<git_signature, git_signature_free>;
   using reference_t   = Guard<git_reference, git_reference_free>;
   using entry_t       = Guard<git_tree_entry, git_tree_entry_free>;
+  using odb_t         = Guard<git_odb, git_odb_free>;
+  using revwalk_t     = Guard<git_revwalk, git_revwalk_free>;
+  using odb_object_t  = Guard<git_odb_object, git_odb_object_free>;
+  using odb_stream_t  = Guard<git_odb_stream, git_odb_stream_free>;
 }
 
 /// @brief Finds a Blob(File) by its full path 
@@ -205,4 +209,36 @@ referenceCommit(git_repository* repo, const std::string& ref) noexcept;
 /// @param blobId The blog `git_oid`
 /// @return On success RAII git_blob otherwise and error
 Result<gd::blob_t>
-getBlobById(git_repository* repo, git_oid const * blobId) noexcept;
\ No newline at end of file
+getBlobById(git_repository* repo, git_oid const * blobId) noexcept;
+
+/// @brief Retrieves the object database of a repository
+/// @param repo A pointer to an open git repository
+/// @return On success RAII git_odb otherwise an Error
+Result<gd::odb_t>
+getOdb(git_repository* repo) noexcept;
+
+/// @brief Reads an object's size and type from its header, without loading (inflating) its content
+/// @param odb The repository's object database
+/// @param oid The object's `git_oid`
+/// @return On success the (size, type) pair of the object, otherwise an Error
+Result<std::pair<size_t, git_object_t>>
+getObjectHeader(git_odb* odb, git_oid const * oid) noexcept;
+
+/// @brief Reads a byte range of a blob's raw content
+/// @param odb The repository's object database
+/// @param blobId The blob's `git_oid`
+/// @param offset The first byte to read, past the blob's end reads nothing
+/// @param length Maximum number of bytes to read
+/// @return On success the bytes in range, otherwise an Error (i.e. not a blob)
+///
+/// Loose (undeltified) objects are inflated only up to the range's end, packed objects are read whole
+Result<std::string>
+getBlobRange(git_odb* odb, git_oid const * blobId, size_t offset, size_t length) noexcept;
+
+/// @brief Finds the latest commit, reachable from `from`, that was committed at or before `time`
+/// @param repo A pointer to an open git repository
+/// @param from The commit to start the search from, usually the tip of a branch
+/// @param time Seconds since epoch
+/// @return On success the commit's `git_oid`, otherwise an Error (NotFound if all commits are later)
+Result<git_oid>
+getCommitByTime(git_repository* repo, git_oid const * from, git_time_t time) noexcept;
@@ -0,0 +1,94 @@
+#pragma once
+#include <coroutine>
+#include <concepts>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+namespace gd {
+
+  /**
+   * A lazily evaluated sequence, produced by a C++20 coroutine
+   *
+   * Values are computed on demand as the range is iterated, one `co_yield` at a time,
+   * allowing to stream arbitrarily large results (i.e. directories with 100k+ entries)
+   * without materializing them in memory. Errors are expected to be yielded as values
+   * (i.e. Generator<Result<T>>), as the library does not throw.
+   *
+   * The Generator is move only, and it's single pass (input range).
+   **/
+  template<std::movable T>
+  class Generator {
+    public:
+
+      // ------------------------- Promise type -----------------------
+      struct promise_type {
+        Generator<T> get_return_object()                      { return Generator{Handle::from_promise(*this)}; }
+        static std::suspend_always initial_suspend() noexcept { return {}; }
+        static std::suspend_always final_suspend() noexcept   { return {}; }
+        std::suspend_always yield_value(T value) noexcept     { current_value.emplace(std::move(value)); return {}; }
+        void return_void() noexcept {}
+
+        void await_transform() = delete;    // Disallow co_await in generator coroutines.
+        [[noreturn]] static void unhandled_exception() noexcept { std::terminate(); }
+
+        std::optional<T> current_value;
+      };
+
+      // ------------------------ Impl --------------------------
+      using Handle = std::coroutine_handle<promise_type>;
+
+      Generator() = default;
+      explicit Generator(const Handle coroutine) : cor_{coroutine} {}
+
+      ~Generator() {
+        if (cor_) {
+          cor_.destroy();
+        }
+      }
+
+      Generator(const Generator&) = delete;
+      Generator& operator=(const Generator&) = delete;
+
+      Generator(Generator&& other)            noexcept : cor_{other.cor_} { other.cor_ = {}; }
+      Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+          if (cor_) { cor_.destroy(); }
+
+          cor_ = other.cor_;
+          other.cor_ = {};
+        }
+        return *this;
+      }
+
+      //  --------------------------- Range support ----------------------------
+      class iterator {
+        public:
+          using iterator_category = std::input_iterator_tag;
+          using difference_type   = std::ptrdiff_t;
+          using value_type        = T;
+
+          iterator() = default;
+          explicit iterator(const Handle coroutine): cor_{coroutine} {}
+
+          iterator& operator++()                         { cor_.resume(); return *this; }
+          void operator++(int)                           { cor_.resume(); }
+          T& operator*() const                           { return *cor_.promise().current_value; }
+          T* operator->() const                          { return &*cor_.promise().current_value; }
+          bool operator==(std::default_sentinel_t) const { return !cor_ || cor_.done(); }
+
+        private:
+          Handle cor_;
+      };
+
+      iterator begin() {
+        if (cor_) { cor_.resume(); }
+        return iterator{cor_};
+      }
+      std::default_sentinel_t end() { return {}; }
+
+    private:
+      Handle cor_;
+  };
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <semaphore>
+#include <utility>
+#include <vector>
+
+namespace gd {
+
+  /**
+   * A lazily started asynchronous computation, produced by a C++20 coroutine
+   *
+   * The task starts when awaited (`co_await task`), and the awaiting coroutine is resumed by the task's
+   * completion, on whichever thread completed it. Top level tasks are run by `syncWait`, groups of tasks
+   * concurrently by `whenAll`. Errors are expected to be returned as values (i.e. Task<Result<T>>),
+   * as the library does not throw.
+   *
+   * The Task is move only, and it's awaited once.
+   **/
+  template<std::movable T>
+  class Task {
+    public:
+
+      // ------------------------- Promise type -----------------------
+      struct promise_type {
+        Task<T> get_return_object()                           { return Task{Handle::from_promise(*this)}; }
+        static std::suspend_always initial_suspend() noexcept { return {}; }
+        void return_value(T value) noexcept                   { value_.emplace(std::move(value)); }
+        [[noreturn]] static void unhandled_exception() noexcept { std::terminate(); }
+
+        // Resumes the awaiting coroutine, if any, by a symmetric transfer
+        struct FinalAwaiter {
+          bool await_ready() const noexcept { return false; }
+          std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> done) noexcept {
+            auto continuation = done.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+          }
+          void await_resume() const noexcept {}
+        };
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+
+        std::optional<T>        value_;
+        std::coroutine_handle<> continuation_;
+      };
+
+      // ------------------------ Impl --------------------------
+      using Handle = std::coroutine_handle<promise_type>;
+
+      Task() = default;
+      explicit Task(const Handle coroutine) : cor_{coroutine} {}
+
+      ~Task() {
+        if (cor_) {
+          cor_.destroy();
+        }
+      }
+
+      Task(const Task&) = delete;
+      Task& operator=(const Task&) = delete;
+
+      Task(Task&& other)            noexcept : cor_{other.cor_} { other.cor_ = {}; }
+      Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+          if (cor_) { cor_.destroy(); }
+
+          cor_ = other.cor_;
+          other.cor_ = {};
+        }
+        return *this;
+      }
+
+      //  --------------------------- Awaiter ----------------------------
+      bool await_ready() const noexcept { return !cor_ || cor_.done(); }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        cor_.promise().continuation_ = awaiting;
+        return cor_;
+      }
+      T await_resume() noexcept { return std::move(*cor_.promise().value_); }
+
+    private:
+      Handle cor_;
+  };
+
+  namespace detail {
+    /// @brief A coroutine started immediately and destroyed on completion, nothing awaits it
+    struct Detached {
+      struct promise_type {
+        Detached get_return_object() noexcept                 { return {}; }
+        static std::suspend_never initial_suspend() noexcept  { return {}; }
+        static std::suspend_never final_suspend() noexcept    { return {}; }
+        void return_void() noexcept {}
+        [[noreturn]] static void unhandled_exception() noexcept { std::terminate(); }
+      };
+    };
+
+    /// @brief Counts down completions, the last one resumes the waiting coroutine
+    struct Join {
+      std::atomic<size_t>     left_;
+      std::coroutine_handle<> waiter_;
+
+      void arrive() noexcept {
+        if (left_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          waiter_.resume();
+      }
+    };
+
+    template<std::movable T>
+    Detached joined(Task<T>& task, std::optional<T>& result, Join& join) {
+      result.emplace(co_await task);
+      join.arrive();
+    }
+
+    template<std::movable T>
+    Detached signaled(Task<T>& task, std::optional<T>& result, std::binary_semaphore& done) {
+      result.emplace(co_await task);
+      done.release();
+    }
+  }
+
+  /// @brief Runs a task, blocking the calling thread until it completes
+  /// @return The task's value
+  ///
+  /// NOTE: Shouldn't be called by a thread the task's work depends on, i.e. a thread of the I/O pool
+  template<std::movable T>
+  T syncWait(Task<T> task) noexcept {
+    std::optional<T> result;
+    std::binary_semaphore done{0};
+    detail::signaled(task, result, done);
+    done.acquire();
+    return std::move(*result);
+  }
+
+  /// @brief Runs tasks concurrently, the awaiting coroutine resumes once all of them completed
+  /// @return The tasks' values, in the order of the tasks
+  template<std::movable T>
+  Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+    std::vector<std::optional<T>> results(tasks.size());
+    detail::Join join{tasks.size() + 1, {}};
+
+    // Tasks are started once the waiter is known, the waiter's own count keeps them from resuming it early
+    struct Awaiter {
+      std::vector<Task<T>>&          tasks_;
+      std::vector<std::optional<T>>& results_;
+      detail::Join&                  join_;
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> waiter) noexcept {
+        join_.waiter_ = waiter;
+        for (size_t i = 0; i < tasks_.size(); ++i)
+          detail::joined(tasks_[i], results_[i], join_);
+        return join_.left_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+      }
+      void await_resume() const noexcept {}
+    };
+
+    Awaiter all{tasks, results, join};
+    co_await all;
+
+    std::vector<T> values;
+    values.reserve(results.size());
+    for (auto& result : results)
+      values.push_back(std::move(*result));
+    co_return values;
+  }
+}
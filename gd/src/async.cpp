@@ -0,0 +1,54 @@
+#include <gd/async.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t sMinIoThreads = 4; /* Work mostly waits on the disk, more threads than cores are useful */
+
+/// @brief A fixed pool of threads running queued work, in queue order
+class IoPool {
+  std::mutex lock_;
+  std::condition_variable_any queued_;
+  std::deque<std::function<void()>> work_;
+  std::vector<std::jthread> threads_; /* Last, stopped and joined first */
+
+  void run(std::stop_token stop) noexcept {
+    while (true) {
+      std::function<void()> next;
+      {
+        std::unique_lock guard(lock_);
+        if (!queued_.wait(guard, stop, [&] { return !work_.empty(); }))
+          return;
+        next = std::move(work_.front());
+        work_.pop_front();
+      }
+      next();
+    }
+  }
+
+public:
+  explicit IoPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i)
+      threads_.emplace_back([this](std::stop_token stop) { run(stop); });
+  }
+
+  void post(std::function<void()> work) noexcept {
+    {
+      std::scoped_lock guard(lock_);
+      work_.push_back(std::move(work));
+    }
+    queued_.notify_one();
+  }
+};
+} // namespace
+
+void gd::internal::postIo(std::function<void()> work) noexcept {
+  static IoPool sPool(std::max<size_t>(sMinIoThreads, std::thread::hardware_concurrency()));
+  sPool.post(std::move(work));
+}
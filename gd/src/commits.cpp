@@ -0,0 +1,224 @@
+#include <gd/commits.h>
+#include <gd/fulltext.h>
+#include <recordlog.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ranges>
+#include <unordered_map>
+
+namespace {
+constexpr char const *sCommitsFile = "gd-commits";
+constexpr gd::internal::LogFormat sFormat{{'G', 'D', 'C', 'I'}, 1, "commit index"};
+
+/// @brief Precedes a commit's strings: ref, author, email then its terms separated by spaces
+struct Record {
+  int64_t  time_;    /* Seconds since the epoch               */
+  git_oid  commit_;
+  git_oid  parent_;  /* Zero for a root commit                */
+  uint32_t ref_;     /* Length of each string                 */
+  uint32_t author_;
+  uint32_t email_;
+  uint32_t terms_;
+};
+static_assert(sizeof(Record) == 64, "Commit index layout is fixed");
+
+std::string commitsPath(git_repository *repo) noexcept {
+  return (std::filesystem::path(git_repository_path(repo)) / sCommitsFile).string();
+}
+
+std::string lowered(std::string value) noexcept {
+  for (auto &c : value)
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return value;
+}
+
+bool before(const gd::CommitRecord &a, const gd::CommitRecord &b) noexcept {
+  return a.time_ < b.time_;
+}
+} // namespace
+
+namespace {
+/// @brief The commits of a load, see `RecordLog`
+struct CommitSegment {
+  std::vector<gd::CommitRecord> commits_; /* By time, then by the order appended */
+  std::unordered_map<std::string, std::vector<size_t>> authors_; /* Lower cased name or email -> commits, by time */
+
+  void listAuthors(size_t from) noexcept {
+    for (auto pos = from; pos < commits_.size(); ++pos) {
+      auto name = lowered(commits_[pos].author_), email = lowered(commits_[pos].email_);
+      authors_[name].push_back(pos);
+      if (email != name)
+        authors_[email].push_back(pos);
+    }
+  }
+
+  size_t read(std::string_view records) noexcept {
+    size_t pos = 0;
+    Record record;
+    while (records.size() - pos >= sizeof(record)) {
+      std::memcpy(&record, records.data() + pos, sizeof(record));
+      size_t strings = size_t(record.ref_) + record.author_ + record.email_ + record.terms_;
+      if (records.size() - pos - sizeof(record) < strings)
+        break;
+
+      auto next = records.data() + pos + sizeof(record);
+      auto take = [&](uint32_t length) {
+        std::string value(next, length);
+        next += length;
+        return value;
+      };
+
+      gd::CommitRecord commit{record.commit_, std::nullopt, take(record.ref_), take(record.author_),
+                              take(record.email_), std::chrono::system_clock::from_time_t(record.time_), {}};
+      if (!git_oid_iszero(&record.parent_))
+        commit.parent_ = record.parent_;
+      for (auto terms = take(record.terms_); !terms.empty();) {
+        auto end = std::min(terms.find(' '), terms.size());
+        commit.terms_.push_back(terms.substr(0, end));
+        terms.erase(0, end + 1);
+      }
+      commits_.push_back(std::move(commit));
+      pos += sizeof(record) + strings;
+    }
+
+    // Appended in commit order, which is time order unless commits raced (or the clock went back)
+    if (!std::is_sorted(commits_.begin(), commits_.end(), before))
+      std::stable_sort(commits_.begin(), commits_.end(), before);
+    listAuthors(0);
+    return pos;
+  }
+
+  void append(const CommitSegment &newer) noexcept {
+    const auto first = commits_.size();
+    commits_.insert(commits_.end(), newer.commits_.begin(), newer.commits_.end());
+    if (first > 0 && first < commits_.size() && before(commits_[first], commits_[first - 1])) {
+      std::inplace_merge(commits_.begin(), commits_.begin() + first, commits_.end(), before);
+      authors_.clear();
+      listAuthors(0);
+    } else {
+      listAuthors(first);
+    }
+  }
+
+  size_t size() const noexcept { return commits_.size(); }
+};
+} // namespace
+
+struct gd::CommitTable : gd::internal::LogTable<CommitSegment> {};
+
+namespace {
+gd::internal::RecordLog<gd::CommitTable> sCommits(sFormat);
+
+/// @brief The ref a commit moved, "HEAD" is resolved to its branch
+std::string refName(git_repository *repo, const std::string &ref) noexcept {
+  if (ref != "HEAD")
+    return ref;
+
+  git_reference *head{nullptr};
+  if (git_repository_head(&head, repo) != 0)
+    return ref;
+
+  gd::reference_t owned{head};
+  return git_reference_name(owned);
+}
+} // namespace
+
+Result<gd::CommitIndex> gd::CommitIndex::open(const gd::Context &ctx) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, "No Repository selected");
+
+  auto table = sCommits.open(commitsPath(*ctx.repo_));
+  if (!table)
+    return gd_unexpected(std::move(table));
+  return CommitIndex(std::move(*table));
+}
+
+std::vector<gd::CommitRecord> gd::CommitIndex::find(const gd::CommitQuery &query) const noexcept {
+  auto ref = query.ref_.empty() || query.ref_.starts_with("refs/") ? query.ref_ : "refs/heads/" + query.ref_;
+  auto terms = TextIndex::terms(query.message_);
+  auto author = lowered(query.author_);
+
+  std::vector<CommitRecord> found;
+  if (query.limit_ == 0)
+    return found;
+
+  // Per segment the commits in the time range, of all the commits or of the author's
+  struct Range {
+    const std::vector<CommitRecord> &commits_;
+    const std::vector<size_t>       *listed_;
+    size_t                           first_, last_;
+
+    const CommitRecord &at(size_t pos) const noexcept { return commits_[listed_ ? (*listed_)[pos] : pos]; }
+  };
+
+  std::vector<Range> ranges;
+  for (const auto &segment : table_->segments_) {
+    Range range{segment->commits_, nullptr, 0, segment->commits_.size()};
+    if (!query.author_.empty()) {
+      auto listed = segment->authors_.find(author);
+      if (listed == segment->authors_.end())
+        continue;
+      range.listed_ = &listed->second;
+      range.last_ = listed->second.size();
+    }
+
+    auto positions = std::views::iota(size_t{0}, range.last_);
+    if (query.since_)
+      range.first_ = *std::ranges::partition_point(positions, [&](size_t pos) { return range.at(pos).time_ < *query.since_; });
+    if (query.until_)
+      range.last_ = *std::ranges::partition_point(positions, [&](size_t pos) { return !(*query.until_ < range.at(pos).time_); });
+    if (range.first_ < range.last_)
+      ranges.push_back(range);
+  }
+
+  // Merged by time, an older segment's commit first on ties
+  while (found.size() < query.limit_) {
+    Range *next = nullptr;
+    for (auto &range : ranges)
+      if (range.first_ < range.last_ && (!next || range.at(range.first_).time_ < next->at(next->first_).time_))
+        next = &range;
+    if (!next)
+      break;
+
+    const auto &commit = next->at(next->first_++);
+    if ((ref.empty() || commit.ref_ == ref) &&
+        std::includes(commit.terms_.begin(), commit.terms_.end(), terms.begin(), terms.end()))
+      found.push_back(commit);
+  }
+  return found;
+}
+
+size_t gd::CommitIndex::size() const noexcept {
+  size_t size = 0;
+  for (const auto &segment : table_->segments_)
+    size += segment->size();
+  return size;
+}
+
+Result<void> gd::internal::appendCommit(git_repository *repo, const git_oid &commitId, git_oid const *parentId,
+                                        const std::string &ref, const git_signature *author,
+                                        const std::string &message) noexcept {
+  std::string terms;
+  for (const auto &term : TextIndex::terms(message))
+    terms += (terms.empty() ? "" : " ") + term;
+
+  auto name = refName(repo, ref);
+  std::string_view who(author->name), email(author->email);
+  Record record{author->when.time, commitId, {}, static_cast<uint32_t>(name.size()),
+                static_cast<uint32_t>(who.size()), static_cast<uint32_t>(email.size()),
+                static_cast<uint32_t>(terms.size())};
+  if (parentId)
+    record.parent_ = *parentId;
+  else
+    std::memset(&record.parent_, 0, sizeof(record.parent_));
+
+  std::string buffer(reinterpret_cast<const char *>(&record), sizeof(record));
+  buffer.append(name).append(who).append(email).append(terms);
+  return sCommits.append(commitsPath(repo), buffer);
+}
+
+void gd::internal::dropCommitIndex(git_repository *repo) noexcept {
+  sCommits.drop(commitsPath(repo));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <git2.h>
+#include <string>
+
+/**
+ * Encodings shared by the library's translation units
+ *
+ * rawOid keys hash maps by the oid bytes, toHex turns arbitrary bytes (keys, paths, ref names)
+ * into names safe for tree entries and files, keeping their order.
+ **/
+
+/// @brief The raw bytes of an oid, used as hash keys
+inline std::string rawOid(const git_oid &oid) noexcept {
+  return std::string(reinterpret_cast<const char *>(oid.id), GIT_OID_RAWSZ);
+}
+
+/// @brief Lower case hex of any bytes, the order of the input is kept
+inline std::string toHex(const std::string &raw) noexcept {
+  constexpr char digits[] = "0123456789abcdef";
+  std::string hex;
+  hex.reserve(raw.size() * 2);
+  for (unsigned char c : raw) {
+    hex += digits[c >> 4];
+    hex += digits[c & 0xf];
+  }
+  return hex;
+}
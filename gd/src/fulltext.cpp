@@ -0,0 +1,451 @@
+#include <gd/fulltext.h>
+#include <gd/async.h>
+#include <encoding.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <out.h>
+
+namespace {
+constexpr char const *sIndexDir = "gd-fulltext";
+constexpr char const *sManifest = "manifest";
+
+std::string segmentName(uint64_t first, uint64_t last) noexcept {
+  return "seg-" + std::to_string(first) + "-" + std::to_string(last);
+}
+
+/// @brief Segment file: a term count, then per term its name, posting count and postings (path, seq, live).
+///        Integers are native 64 bit, strings are length prefixed.
+Result<void> writeSegment(const std::filesystem::path &file, const gd::TextIndex::Segment &segment) noexcept {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  auto put = [&](uint64_t value) { out.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+  auto putString = [&](const std::string &value) {
+    put(value.size());
+    out.write(value.data(), value.size());
+  };
+
+  put(segment.postings_.size());
+  for (const auto &[term, postings] : segment.postings_) {
+    putString(term);
+    put(postings.size());
+    for (const auto &posting : postings) {
+      putString(posting.path_);
+      put(posting.seq_);
+      put(posting.live_);
+    }
+  }
+
+  out.close();
+  if (!out)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed writing segment " + file.string());
+  return Result<void>();
+}
+
+/// @brief Reads a segment file, every count and length is checked against the bytes left
+Result<void> readSegment(const std::filesystem::path &file, gd::TextIndex::Segment &segment) noexcept {
+  std::error_code failed;
+  auto size = std::filesystem::file_size(file, failed);
+  std::ifstream in(file, std::ios::binary);
+  std::string bytes;
+  if (!failed && in) {
+    bytes.resize(size);
+    in.read(bytes.data(), bytes.size());
+  }
+  if (failed || !in)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed reading segment " + file.string());
+
+  constexpr size_t sMinTerm = 2 * sizeof(uint64_t);    /* Name length and posting count */
+  constexpr size_t sMinPosting = 3 * sizeof(uint64_t); /* Path length, seq and live     */
+
+  std::string_view rest{bytes};
+  bool malformed = false;
+  auto get = [&]() {
+    uint64_t value{0};
+    if (rest.size() < sizeof(value)) {
+      malformed = true;
+      return value;
+    }
+    std::memcpy(&value, rest.data(), sizeof(value));
+    rest.remove_prefix(sizeof(value));
+    return value;
+  };
+  auto getString = [&]() {
+    auto length = get();
+    if (length > rest.size()) {
+      malformed = true;
+      return std::string();
+    }
+    std::string value{rest.substr(0, length)};
+    rest.remove_prefix(length);
+    return value;
+  };
+
+  auto terms = get();
+  malformed |= terms > rest.size() / sMinTerm;
+  for (; !malformed && terms > 0; --terms) {
+    auto term = getString();
+    auto count = get();
+    if (malformed || count > rest.size() / sMinPosting) {
+      malformed = true;
+      break;
+    }
+
+    auto &postings = segment.postings_[std::move(term)];
+    for (; count > 0; --count) {
+      auto path = getString();
+      auto seq = get();
+      auto live = get();
+      if (malformed)
+        break;
+      postings.push_back({std::move(path), seq, live != 0});
+    }
+  }
+
+  if (malformed)
+    return gd_unexpected(gd::ErrorType::BadFile, "Malformed segment " + file.string());
+  return Result<void>();
+}
+
+bool isIndexed(const std::filesystem::path &fullpath) noexcept {
+  return !fullpath.empty() && *fullpath.begin() != ".gd";
+}
+} // namespace
+
+size_t gd::TextIndex::Segment::size() const noexcept {
+  size_t size = 0;
+  for (const auto &[_, postings] : postings_)
+    size += postings.size();
+  return size;
+}
+
+std::vector<std::string> gd::TextIndex::terms(const std::string &content) noexcept {
+  std::set<std::string> unique;
+  std::string term;
+  for (unsigned char c : content + ' ') {
+    if (std::isalnum(c)) {
+      term += static_cast<char>(std::tolower(c));
+    } else if (!term.empty()) {
+      unique.insert(std::move(term));
+      term.clear();
+    }
+  }
+  return std::vector<std::string>(unique.begin(), unique.end());
+}
+
+gd::TextIndex::TextIndex(repository_t *repo, std::string ref, std::filesystem::path dir,
+                         TextIndexOptions opts) noexcept
+    : repo_{repo}, ref_{std::move(ref)}, dir_{std::move(dir)}, opts_{opts} {}
+
+gd::TextIndex::~TextIndex() {
+  if (observer_)
+    removeObserver(*observer_);
+}
+
+Result<std::shared_ptr<gd::TextIndex>> gd::TextIndex::open(const Context &ctx, TextIndexOptions opts) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, "No Repository selected");
+
+  auto dir = std::filesystem::path(git_repository_path(*ctx.repo_)) / sIndexDir / toHex(ctx.ref_);
+  std::error_code failed;
+  std::filesystem::create_directories(dir, failed);
+  if (failed)
+    return gd_unexpected(gd::ErrorType::BadDir, "Failed creating " + dir.string() + ": " + failed.message());
+
+  std::shared_ptr<TextIndex> index{new TextIndex(ctx.repo_, ctx.ref_, std::move(dir), opts)};
+  if (auto loaded = index->load(); !loaded)
+    return gd_unexpected(std::move(loaded));
+
+  if (auto updated = index->update(); !updated)
+    return gd_unexpected(std::move(updated));
+
+  if (opts.live_) {
+    // Commits to other branches leave the ref's tip as is, updating finds nothing to index.
+    // The update runs on the I/O pool, off the committing thread, and commits landing while one is
+    // queued are caught up by it.
+    std::weak_ptr<TextIndex> weak = index;
+    auto observer = observeCommits(ctx, [weak](const Context &) {
+      auto index = weak.lock();
+      if (!index || index->queued_.exchange(true))
+        return;
+      internal::postIo([weak] {
+        if (auto index = weak.lock()) {
+          index->queued_ = false;
+          index->update();
+        }
+      });
+    });
+    if (!observer)
+      return gd_unexpected(std::move(observer));
+    index->observer_ = *observer;
+  }
+
+  return index;
+}
+
+/// @brief Manifest: one line per indexed commit ("commit <hex>") in sequence order, then one line per
+///        segment ("segment <first> <last> <file>")
+Result<void> gd::TextIndex::load() noexcept {
+  std::ifstream in(dir_ / sManifest);
+  if (!in)
+    return Result<void>(); // A new index
+
+  std::string kind;
+  while (in >> kind) {
+    if (kind == "commit") {
+      std::string hex;
+      in >> hex;
+      git_oid commitId;
+      if (git_oid_fromstrn(&commitId, hex.data(), hex.size()) != 0)
+        return gd_unexpected();
+      commits_.push_back(commitId);
+      seqs_[rawOid(commitId)] = commits_.size();
+    } else if (kind == "segment") {
+      Segment segment;
+      in >> segment.first_ >> segment.last_ >> segment.file_;
+      if (auto read = readSegment(dir_ / segment.file_, segment); !read)
+        return read;
+      segments_.push_back(std::move(segment));
+    } else {
+      return gd_unexpected(gd::ErrorType::BadFile, "Malformed manifest " + (dir_ / sManifest).string());
+    }
+  }
+  return Result<void>();
+}
+
+Result<void> gd::TextIndex::save() const noexcept {
+  auto manifest = dir_ / sManifest;
+  auto written = dir_ / (std::string(sManifest) + ".new");
+  {
+    std::ofstream out(written, std::ios::trunc);
+    char hex[GIT_OID_HEXSZ + 1];
+    for (const auto &commitId : commits_)
+      out << "commit " << git_oid_tostr(hex, sizeof(hex), &commitId) << "\n";
+    for (const auto &segment : segments_)
+      out << "segment " << segment.first_ << " " << segment.last_ << " " << segment.file_ << "\n";
+
+    out.close();
+    if (!out)
+      return gd_unexpected(gd::ErrorType::BadFile, "Failed writing " + written.string());
+  }
+
+  std::error_code failed;
+  std::filesystem::rename(written, manifest, failed); // Atomically replaces the former manifest
+  if (failed)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed replacing " + manifest.string() + ": " + failed.message());
+  return Result<void>();
+}
+
+Result<size_t> gd::TextIndex::update() noexcept {
+  std::unique_lock guard(lock_);
+
+  Context ctx(repo_, ref_);
+  if (!ctx.getCommitId()) // Nothing committed yet
+    return 0;
+
+  // The branch's new commits, along the first parent chain, back to the last indexed one
+  std::vector<git_oid> chain;
+  git_oid at = *ctx.getCommitId();
+  if (seqs_.contains(rawOid(at))) {
+    if (!git_oid_equal(&at, &commits_.back())) // The branch was reset to an older commit
+      chain.push_back(at);
+  } else {
+    while (!seqs_.contains(rawOid(at))) {
+      chain.push_back(at);
+      auto commit = getCommitById(*repo_, &at);
+      if (!commit)
+        return gd_unexpected(std::move(commit));
+      if (git_commit_parentcount(*commit) == 0)
+        break;
+      at = *git_commit_parent_id(*commit, 0);
+    }
+  }
+
+  std::optional<git_oid> from;
+  if (!commits_.empty())
+    from = commits_.back();
+
+  for (auto commitId = chain.rbegin(); commitId != chain.rend(); ++commitId) {
+    if (auto indexed = index(ctx, from, *commitId); !indexed)
+      return gd_unexpected(std::move(indexed));
+    from = *commitId;
+  }
+
+  if (chain.empty())
+    return 0;
+
+  if (auto merged = merge(); !merged)
+    return gd_unexpected(std::move(merged));
+
+  return chain.size();
+}
+
+/// @brief Indexes one commit, as the changes from the last indexed commit (or from nothing)
+Result<void> gd::TextIndex::index(const Context &ctx, std::optional<git_oid> from, const git_oid &to) noexcept {
+  const uint64_t seq = commits_.size() + 1;
+  Segment segment{seq, seq, segmentName(seq, seq), {}};
+
+  auto termsOf = [&](const git_oid &blobId) -> Result<std::vector<std::string>> {
+    auto blob = getBlobById(*repo_, &blobId);
+    if (!blob)
+      return gd_unexpected(std::move(blob));
+    return terms(std::string(static_cast<const char *>(git_blob_rawcontent(*blob)), git_blob_rawsize(*blob)));
+  };
+
+  auto post = [&](const std::vector<std::string> &terms, const std::vector<std::string> &except,
+                  const std::filesystem::path &fullpath, bool live) {
+    for (const auto &term : terms)
+      if (!std::binary_search(except.begin(), except.end(), term))
+        segment.postings_[term].push_back({fullpath.string(), seq, live});
+  };
+
+  if (!from) {
+    auto snap = snapshot(ctx, to);
+    if (!snap)
+      return gd_unexpected(std::move(snap));
+
+    for (auto &&item : snap->walk()) {
+      if (!item)
+        return gd_unexpected(std::move(item));
+      if (item->isDir() || !isIndexed(item->path_))
+        continue;
+
+      auto added = termsOf(item->oid_);
+      if (!added)
+        return gd_unexpected(std::move(added));
+      post(*added, {}, item->path_, true);
+    }
+  } else {
+    for (auto &&change : diff(ctx, *from, to)) {
+      if (!change)
+        return gd_unexpected(std::move(change));
+      if (!isIndexed(change->path_) && !isIndexed(change->from_))
+        continue;
+
+      std::vector<std::string> before, after;
+      if (change->type_ != ChangeType::Added) {
+        auto terms = termsOf(change->oldOid_);
+        if (!terms)
+          return gd_unexpected(std::move(terms));
+        before = std::move(*terms);
+      }
+      if (change->type_ != ChangeType::Deleted) {
+        auto terms = termsOf(change->newOid_);
+        if (!terms)
+          return gd_unexpected(std::move(terms));
+        after = std::move(*terms);
+      }
+
+      if (change->type_ == ChangeType::Renamed) {
+        post(before, {}, change->from_, false);
+        post(after, {}, change->path_, true);
+      } else { // Only terms added or removed are posted
+        post(before, after, change->path_, false);
+        post(after, before, change->path_, true);
+      }
+    }
+  }
+
+  if (!segment.postings_.empty()) {
+    if (auto written = writeSegment(dir_ / segment.file_, segment); !written)
+      return written;
+    segments_.push_back(std::move(segment));
+  }
+
+  commits_.push_back(to);
+  seqs_[rawOid(to)] = seq;
+  return Result<void>();
+}
+
+/// @brief Merges adjacent segments, the pair with the fewest postings first, until the segment count
+///        is within bounds. The manifest is saved before the merged segments' files are removed.
+Result<void> gd::TextIndex::merge() noexcept {
+  std::vector<std::string> obsolete;
+  while (segments_.size() > std::max<size_t>(opts_.maxSegments_, 1)) {
+    size_t smallest = 0, smallestSize = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i + 1 < segments_.size(); ++i)
+      if (auto size = segments_[i].size() + segments_[i + 1].size(); size < smallestSize) {
+        smallest = i;
+        smallestSize = size;
+      }
+
+    auto &older = segments_[smallest];
+    auto &newer = segments_[smallest + 1];
+    Segment merged{older.first_, newer.last_, segmentName(older.first_, newer.last_), std::move(older.postings_)};
+    for (auto &[term, postings] : newer.postings_) {
+      auto &into = merged.postings_[term];
+      into.insert(into.end(), std::make_move_iterator(postings.begin()), std::make_move_iterator(postings.end()));
+    }
+
+    if (auto written = writeSegment(dir_ / merged.file_, merged); !written)
+      return written;
+
+    obsolete.push_back(older.file_);
+    obsolete.push_back(newer.file_);
+    segments_[smallest] = std::move(merged);
+    segments_.erase(segments_.begin() + smallest + 1);
+  }
+
+  if (auto saved = save(); !saved)
+    return saved;
+
+  std::error_code ignored;
+  for (const auto &file : obsolete)
+    std::filesystem::remove(dir_ / file, ignored);
+  return Result<void>();
+}
+
+std::vector<std::filesystem::path> gd::TextIndex::find(const std::string &query, uint64_t seq) const noexcept {
+  std::optional<std::set<std::string>> found;
+  for (const auto &term : terms(query)) {
+    std::map<std::string, std::pair<uint64_t, bool>> latest; // path -> latest (seq, live) up to `seq`
+    for (const auto &segment : segments_) {
+      if (segment.first_ > seq)
+        break;
+      if (auto postings = segment.postings_.find(term); postings != segment.postings_.end())
+        for (const auto &posting : postings->second)
+          if (auto &[at, live] = latest[posting.path_]; posting.seq_ <= seq && posting.seq_ >= at) {
+            at = posting.seq_;
+            live = posting.live_;
+          }
+    }
+
+    std::set<std::string> holding;
+    for (const auto &[path, state] : latest)
+      if (state.second)
+        holding.insert(path);
+
+    if (found) {
+      std::erase_if(*found, [&](const auto &path) { return !holding.contains(path); });
+    } else {
+      found = std::move(holding);
+    }
+  }
+
+  return found ? std::vector<std::filesystem::path>(found->begin(), found->end())
+               : std::vector<std::filesystem::path>{};
+}
+
+Result<std::vector<std::filesystem::path>> gd::TextIndex::search(const std::string &query) const noexcept {
+  std::shared_lock guard(lock_);
+  return find(query, commits_.size());
+}
+
+Result<std::vector<std::filesystem::path>> gd::TextIndex::search(const std::string &query,
+                                                                 const git_oid &commitId) const noexcept {
+  std::shared_lock guard(lock_);
+  auto seq = seqs_.find(rawOid(commitId));
+  if (seq == seqs_.end())
+    return gd_unexpected(gd::ErrorType::NotFound, fmt::format("Commit {} isn't indexed", commitId));
+
+  return find(query, seq->second);
+}
+
+size_t gd::TextIndex::segments() const noexcept {
+  std::shared_lock guard(lock_);
+  return segments_.size();
+}
@@ -1,15 +1,26 @@
 #include <gd/gd.h>
+#include <gd/commits.h>
+#include <gd/manifest.h>
+#include <gd/pathfilter.h>
+#include <encoding.h>
 #include <pathTraverse.h>
 #include <ranges>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <expected.h>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <out.h>
+#include <regex>
 #include <shared_mutex>
 #include <spdlog/sinks/null_sink.h>
 #include <spdlog/spdlog.h>
+#include <string_view>
 
 using namespace std::ranges;
 
@@ -20,6 +31,345 @@ std::ostream &operator<<(std::ostream &os, const gd::Error &e) noexcept {
 /// @brief An anonymous namespace to keep some implementation details, locally
 namespace {
 static char const *const sNoRepositoryError{"No Repository selected"};
+static char const *const sNoSessionError{"No session"};
+
+/// @brief Secondary indexes registered per repository, for the process lifetime
+class IndexRegistry {
+  std::shared_mutex lock_;
+  std::map<git_repository *, std::vector<gd::Index>> indexes_;
+
+public:
+  void add(git_repository *repo, const gd::Index &index) noexcept {
+    std::unique_lock guard(lock_);
+    auto &indexes = indexes_[repo];
+    auto same = std::ranges::find(indexes, index.name_, &gd::Index::name_);
+    if (same != indexes.end())
+      *same = index;
+    else
+      indexes.push_back(index);
+  }
+
+  void drop(git_repository *repo) noexcept {
+    std::unique_lock guard(lock_);
+    indexes_.erase(repo);
+  }
+
+  std::vector<gd::Index> of(git_repository *repo) noexcept {
+    std::shared_lock guard(lock_);
+    auto indexes = indexes_.find(repo);
+    return indexes == indexes_.end() ? std::vector<gd::Index>{} : indexes->second;
+  }
+};
+static IndexRegistry sIndexes;
+
+/// @brief Commit observers registered per repository
+class ObserverRegistry {
+  std::shared_mutex lock_;
+  size_t lastId_{0};
+  std::map<size_t, std::pair<git_repository *, gd::CommitObserver>> observers_;
+
+public:
+  size_t add(git_repository *repo, gd::CommitObserver observer) noexcept {
+    std::unique_lock guard(lock_);
+    observers_.emplace(++lastId_, std::make_pair(repo, std::move(observer)));
+    return lastId_;
+  }
+
+  void remove(size_t id) noexcept {
+    std::unique_lock guard(lock_);
+    observers_.erase(id);
+  }
+
+  void drop(git_repository *repo) noexcept {
+    std::unique_lock guard(lock_);
+    std::erase_if(observers_, [repo](const auto &observer) { return observer.second.first == repo; });
+  }
+
+  /// @brief Notifies outside the lock, observers may (un)register observers
+  void notify(const gd::Context &ctx) noexcept {
+    std::vector<gd::CommitObserver> notified;
+    {
+      std::shared_lock guard(lock_);
+      for (const auto &[_, observer] : observers_)
+        if (observer.first == *ctx.repo_)
+          notified.push_back(observer.second);
+    }
+    for (const auto &observer : notified)
+      observer(ctx);
+  }
+};
+static ObserverRegistry sObservers;
+
+/// @brief Repositories keeping a per commit record, i.e. a manifest
+class RepositorySet {
+  std::shared_mutex lock_;
+  std::set<git_repository *> repos_;
+
+public:
+  void add(git_repository *repo) noexcept {
+    std::unique_lock guard(lock_);
+    repos_.insert(repo);
+  }
+
+  void drop(git_repository *repo) noexcept {
+    std::unique_lock guard(lock_);
+    repos_.erase(repo);
+  }
+
+  bool contains(git_repository *repo) noexcept {
+    std::shared_lock guard(lock_);
+    return repos_.contains(repo);
+  }
+};
+static RepositorySet sManifests;
+static RepositorySet sPathFilters;
+static RepositorySet sCommitIndexes;
+
+/**
+ * Branch tips as last known in process, per repository and ref
+ *
+ * Each move of a tip by a commit, or a created branch, is a new generation
+ * (unique across tips), a node synced with a generation is at that tip.
+ * - A tip's (oid, generation) is published in a seqlock, read without locking,
+ *   and tips are found in a per thread snapshot of an immutable directory
+ * - Moves in process are published by their writer (`moved`)
+ * - Moves by other writers (i.e. git CLI) are read from disk by `refresh`, on
+ *   commit and on an explicit rebase, otherwise at most once per
+ *   `sTipRecheck` per tip
+ **/
+class TipTable {
+public:
+  struct Seen {
+    git_oid id_;
+    uint64_t generation_;
+  };
+
+  /// @brief A tip's commit and root tree, as loaded at a generation
+  struct Loaded {
+    uint64_t generation_;
+    gd::commit_t commit_;
+    gd::tree_t root_;
+  };
+
+private:
+  static constexpr std::chrono::nanoseconds sTipRecheck = std::chrono::milliseconds(10);
+
+  struct Tip {
+    static constexpr size_t sWords = (GIT_OID_RAWSZ + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence_{0}; /* Odd while published               */
+    std::array<std::atomic<uint64_t>, sWords> id_{};
+    std::atomic<uint64_t> generation_{0}; /* Zero until read                 */
+    std::atomic<int64_t> checked_{0};     /* Last read from disk, steady ns  */
+
+    std::mutex lock_;    /* Serializes writers                              */
+    std::string direct_; /* The ref "HEAD" follows, written under the lock  */
+    std::atomic<std::shared_ptr<const Loaded>> loaded_; /* Last loaded tip */
+
+    /// @brief Called while holding the lock
+    void publish(const git_oid &id, uint64_t generation) noexcept {
+      std::array<uint64_t, sWords> words{};
+      std::memcpy(words.data(), id.id, GIT_OID_RAWSZ);
+
+      auto sequence = sequence_.load(std::memory_order_relaxed);
+      sequence_.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (size_t i = 0; i < sWords; ++i)
+        id_[i].store(words[i], std::memory_order_relaxed);
+      generation_.store(generation, std::memory_order_relaxed);
+      sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    Seen read() const noexcept {
+      while (true) {
+        auto sequence = sequence_.load(std::memory_order_acquire);
+        if (sequence & 1)
+          continue;
+
+        std::array<uint64_t, sWords> words;
+        for (size_t i = 0; i < sWords; ++i)
+          words[i] = id_[i].load(std::memory_order_relaxed);
+        Seen seen{{}, generation_.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != sequence)
+          continue;
+
+        std::memcpy(seen.id_.id, words.data(), GIT_OID_RAWSZ);
+        return seen;
+      }
+    }
+  };
+
+  using Tips = std::map<std::string, std::shared_ptr<Tip>, std::less<>>;
+
+  /// @brief Tips by repository and ref, immutable once published
+  struct Directory {
+    std::unordered_map<git_repository *, Tips> repos_;
+  };
+
+  /// @brief The directory last seen by a thread
+  struct Snapshot {
+    std::shared_ptr<const Directory> directory_;
+    uint64_t version_ = 0;
+  };
+
+  std::mutex lock_; /* Serializes directory changes */
+  std::shared_ptr<const Directory> directory_{std::make_shared<const Directory>()};
+  std::atomic<uint64_t> version_{1};
+  std::atomic<uint64_t> generations_{0};
+  static thread_local Snapshot snapshot_;
+
+  static int64_t now() noexcept {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+
+  /// @brief The directory, refreshed only when a directory was published
+  /// since the thread's last look
+  const Directory &current() noexcept {
+    if (snapshot_.version_ != version_.load(std::memory_order_acquire)) {
+      std::scoped_lock guard(lock_);
+      snapshot_ = {directory_, version_.load(std::memory_order_relaxed)};
+    }
+    return *snapshot_.directory_;
+  }
+
+  /// @return The tip, valid as long as the thread's snapshot isn't refreshed
+  Tip &tipOf(git_repository *repo, std::string_view ref) noexcept {
+    while (true) { // The repository may be dropped (i.e. cleanRepo) between an insert and its lookup
+      const auto &found = current();
+      if (auto tips = found.repos_.find(repo); tips != found.repos_.end())
+        if (auto tip = tips->second.find(ref); tip != tips->second.end())
+          return *tip->second;
+
+      std::scoped_lock guard(lock_);
+      if (auto tips = directory_->repos_.find(repo);
+          tips == directory_->repos_.end() || !tips->second.contains(ref)) {
+        auto directory = std::make_shared<Directory>(*directory_);
+        directory->repos_[repo].emplace(std::string(ref), std::make_shared<Tip>());
+        directory_ = std::move(directory);
+        version_.fetch_add(1, std::memory_order_release);
+      }
+    }
+  }
+
+  /// @brief Reads a tip from disk, a new generation when it moved
+  Result<Seen> refresh(git_repository *repo, const std::string &ref, Tip &tip,
+                       bool force) noexcept {
+    std::scoped_lock guard(tip.lock_);
+    auto published = tip.read();
+    if (!force && published.generation_ != 0 &&
+        now() - tip.checked_.load(std::memory_order_relaxed) < sTipRecheck.count())
+      return published; // Read by another thread meanwhile
+
+    git_reference *found{nullptr}, *direct{nullptr};
+    if (git_reference_lookup(&found, repo, ref.c_str()) != 0)
+      return gd_unexpected();
+    gd::reference_t owned{found};
+    if (git_reference_resolve(&direct, found) != 0)
+      return gd_unexpected();
+    gd::reference_t ownedDirect{direct};
+
+    tip.direct_ = git_reference_name(direct);
+    if (published.generation_ == 0 ||
+        !git_oid_equal(&published.id_, git_reference_target(direct))) {
+      published = {*git_reference_target(direct), ++generations_};
+      tip.publish(published.id_, published.generation_);
+    }
+    tip.checked_.store(now(), std::memory_order_relaxed);
+    return published;
+  }
+
+public:
+  /// @brief The tip of a ref, read from disk only when it wasn't checked
+  /// recently (or never read)
+  Result<Seen> seen(git_repository *repo, const std::string &ref) noexcept {
+    auto &tip = tipOf(repo, ref);
+    if (auto published = tip.read();
+        published.generation_ != 0 &&
+        now() - tip.checked_.load(std::memory_order_relaxed) < sTipRecheck.count())
+      return published;
+    return refresh(repo, ref, tip, false);
+  }
+
+  /// @brief The tip of a ref, read from disk
+  Result<Seen> refresh(git_repository *repo, const std::string &ref) noexcept {
+    return refresh(repo, ref, tipOf(repo, ref), true);
+  }
+
+  /// @brief Records a tip moved in process, its aliases (i.e. "HEAD") too
+  /// @return The new generation of the tip
+  ///
+  /// Called by the writer right after moving the tip, while writers of the
+  /// ref are serialized
+  uint64_t moved(git_repository *repo, const std::string &ref,
+                 const git_oid &id) noexcept {
+    std::string direct = ref;
+    git_reference *found{nullptr};
+    if (git_reference_lookup(&found, repo, ref.c_str()) == 0) {
+      gd::reference_t owned{found};
+      if (git_reference_type(found) == GIT_REFERENCE_SYMBOLIC)
+        direct = git_reference_symbolic_target(found);
+    }
+
+    auto generation = ++generations_;
+    tipOf(repo, direct); // Known from now on, even if not read yet
+    const auto &directory = current();
+    auto tips = directory.repos_.find(repo);
+    if (tips == directory.repos_.end())
+      return generation;
+
+    for (const auto &[name, tip] : tips->second) {
+      std::scoped_lock update(tip->lock_);
+      if (name != ref && name != direct && tip->direct_ != direct)
+        continue;
+      tip->direct_ = direct;
+      tip->publish(id, generation);
+      tip->checked_.store(now(), std::memory_order_relaxed);
+    }
+    return generation;
+  }
+
+  /// @brief The commit and root tree last loaded for a tip, when still at the
+  /// generation, re-selecting the tip then skips their lookups
+  std::shared_ptr<const Loaded> loaded(git_repository *repo,
+                                       const std::string &ref,
+                                       uint64_t generation) noexcept {
+    auto loaded = tipOf(repo, ref).loaded_.load(std::memory_order_acquire);
+    return loaded && loaded->generation_ == generation ? loaded : nullptr;
+  }
+
+  /// @brief Keeps the commit and root tree loaded for a tip at a generation
+  void keep(git_repository *repo, const std::string &ref, uint64_t generation,
+            git_commit *commit, git_tree *root) noexcept {
+    git_commit *keptCommit{nullptr};
+    git_tree *keptRoot{nullptr};
+    if (git_commit_dup(&keptCommit, commit) != 0)
+      return;
+    gd::commit_t ownedCommit{keptCommit};
+    if (git_tree_dup(&keptRoot, root) != 0)
+      return;
+
+    tipOf(repo, ref).loaded_.store(
+        std::make_shared<const Loaded>(generation, std::move(ownedCommit), gd::tree_t{keptRoot}),
+        std::memory_order_release);
+  }
+
+  /// @brief Forgets a repository's tips, their loaded objects are released
+  /// while the repository is still open
+  void drop(git_repository *repo) noexcept {
+    std::scoped_lock guard(lock_);
+    if (auto tips = directory_->repos_.find(repo); tips != directory_->repos_.end())
+      for (const auto &[_, tip] : tips->second)
+        tip->loaded_.store(nullptr, std::memory_order_release);
+
+    auto directory = std::make_shared<Directory>(*directory_);
+    directory->repos_.erase(repo);
+    directory_ = std::move(directory);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+};
+thread_local TipTable::Snapshot TipTable::snapshot_;
+static TipTable sTips;
 
 /**
  * Git accessor abstraction
@@ -48,22 +398,48 @@ static char const *const sNoRepositoryError{"No Repository selected"};
  *out.
  **/
 class GitAccess {
+  /// @brief Open repositories by full path, immutable once published
+  struct Registry {
+    struct Hash {
+      using is_transparent = void;
+      size_t operator()(std::string_view path) const noexcept {
+        return std::hash<std::string_view>{}(path);
+      }
+    };
+    std::unordered_map<std::string, gd::repository_t *, Hash, std::equal_to<>>
+        repos_;
+  };
+
+  /// @brief The registry last seen by a thread
+  struct Snapshot {
+    std::shared_ptr<const Registry> registry_;
+    uint64_t version_ = 0;
+  };
+
 public:
   GitAccess() { git_libgit2_init(); }
 
   ~GitAccess() {
-    std::lock_guard<std::shared_mutex> lock(cacheAccess_);
+    std::scoped_lock lock(writeAccess_);
+    registry_.reset();
     repoCache_.clear();
     git_libgit2_shutdown();
   }
 
   /// @brief Cache a repository for the duration of the application
-  /// @param ...args path, repository pair to be kept in a hash table
+  /// @param fullpath path to the repository, the key of the cache
+  /// @param repo the open repository, dropped when it was already cached
   /// @return A pointer to repository_t, the pointer is guaranteed to be safe to
   /// use as repositories are open for the entire life time of the application.
-  template <typename... Ts> gd::repository_t *cacheRepo(Ts &&...args) {
-    std::lock_guard<std::shared_mutex> lock(cacheAccess_);
-    auto [itr, _] = repoCache_.emplace(std::forward<Ts>(args)...);
+  gd::repository_t *cacheRepo(const std::filesystem::path &fullpath,
+                              gd::repository_t &&repo) {
+    std::scoped_lock lock(writeAccess_);
+    auto [itr, added] = repoCache_.emplace(fullpath.native(), std::move(repo));
+    if (added) {
+      auto registry = std::make_shared<Registry>(*registry_);
+      registry->repos_.emplace(itr->first, &itr->second);
+      publish(std::move(registry));
+    }
     ctx_.setRepo(&itr->second);
     return &itr->second;
   }
@@ -72,11 +448,14 @@ public:
   /// @param repoFullPath  full path to the repository on the file system
   /// @return a pointer to an already opend repository, or an error, when such
   /// repository wasn't opened/created yet.
-  Result<gd::repository_t *> getRepo(const std::string &repoFullPath) {
-    std::shared_lock<std::shared_mutex> guard(cacheAccess_);
-    if (auto itr{repoCache_.find(repoFullPath)}; itr != repoCache_.end()) {
-      ctx_.setRepo(&itr->second);
-      return &itr->second;
+  ///
+  /// Lock free, unless the registry changed since the thread's last lookup
+  Result<gd::repository_t *> getRepo(const std::filesystem::path &repoFullPath) {
+    const auto &repos = current().repos_;
+    if (auto itr{repos.find(std::string_view(repoFullPath.native()))};
+        itr != repos.end()) {
+      ctx_.setRepo(itr->second);
+      return itr->second;
     }
 
     return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
@@ -85,15 +464,34 @@ public:
   /// @brief Removes directory 'repoFullPath' if exists
   /// @param repoFullPath Path to the Repository
   /// @return True if the repository existed, otherwise false
+  ///
+  /// NOTE: The repository is closed, it's not to be used (by any thread) while
+  /// it's removed
   bool cleanRepo(const std::filesystem::path &repoFullPath) noexcept {
     bool removed = false;
-    std::shared_lock<std::shared_mutex> guard(cacheAccess_);
-    if (auto itr{repoCache_.find(repoFullPath)}; itr != repoCache_.end()) {
-      repoCache_.erase(repoFullPath);
-      removed = true;
+    {
+      std::scoped_lock lock(writeAccess_);
+      if (auto itr{repoCache_.find(repoFullPath.native())};
+          itr != repoCache_.end()) {
+        sIndexes.drop(itr->second);
+        sObservers.drop(itr->second);
+        sManifests.drop(itr->second);
+        sPathFilters.drop(itr->second);
+        gd::internal::dropPathFilters(itr->second);
+        sCommitIndexes.drop(itr->second);
+        sTips.drop(itr->second);
+        gd::internal::dropCommitIndex(itr->second);
+
+        auto registry = std::make_shared<Registry>(*registry_);
+        registry->repos_.erase(itr->first);
+        publish(std::move(registry));
+        repoCache_.erase(itr);
+        removed = true;
+      }
     }
+
+    // Outside the lock, other repositories are opened meanwhile
     std::filesystem::remove_all(repoFullPath);
-    ;
     return removed;
   }
 
@@ -115,10 +513,67 @@ public:
     ctx_.setBranch(fullPathRef);
   }
 
+  /// @brief The thread's session, kept across calls once begun, otherwise a
+  /// fresh context per call
+  Result<gd::Context> &threadSession() noexcept {
+    if (!inSession_)
+      session_ = threadContext();
+    return session_;
+  }
+
+  /// @brief Begins a session at the tip of the thread's repository and branch,
+  /// an ongoing session is dropped
+  Result<void> beginSession() noexcept {
+    session_ = threadContext();
+    inSession_ = session_.has_value();
+    if (!inSession_)
+      return gd_unexpected(session_.error());
+    return Result<void>();
+  }
+
+  /// @brief Carries the session on from a context, i.e. the context of a
+  /// read's result: its tip, updates and reads are moved back to the session,
+  /// the context keeps its repository and branch
+  void resumeSession(gd::Context &ctx) noexcept {
+    gd::Context resumed(std::move(ctx));
+    ctx.repo_ = resumed.repo_;
+    ctx.ref_ = resumed.ref_;
+    session_ = std::move(resumed);
+  }
+
+  /// @brief Ends the session, dropping its uncommitted updates
+  void endSession() noexcept {
+    inSession_ = false;
+    session_ = gd_unexpected(gd::ErrorType::MissingRepository, sNoSessionError);
+  }
+
 private:
-  std::shared_mutex cacheAccess_;
-  std::unordered_map<std::filesystem::path, gd::repository_t> repoCache_;
+  /// @brief The thread's registry, refreshed (under the writers' lock) only
+  /// when a newer one was published
+  const Registry &current() {
+    auto version = version_.load(std::memory_order_acquire);
+    if (!seen_.registry_ || seen_.version_ != version) {
+      std::scoped_lock lock(writeAccess_);
+      seen_ = {registry_, version_.load(std::memory_order_relaxed)};
+    }
+    return *seen_.registry_;
+  }
+
+  /// @brief Replaces the registry, the replaced one is released once no thread
+  /// holds it. Called by writers, holding `writeAccess_`
+  void publish(std::shared_ptr<const Registry> registry) noexcept {
+    registry_ = std::move(registry);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  std::mutex writeAccess_; /* Serializes writers, and registry refreshes */
+  std::shared_ptr<const Registry> registry_{std::make_shared<Registry>()};
+  std::atomic<uint64_t> version_{0}; /* Bumped by each published registry */
+  std::unordered_map<std::string, gd::repository_t> repoCache_; /* Owner */
   static thread_local gd::Context ctx_;
+  static thread_local Snapshot seen_;
+  static thread_local Result<gd::Context> session_;
+  static thread_local bool inSession_;
 };
 
 static GitAccess sGit; // Git representation
@@ -128,10 +583,45 @@ static std::string sHead{
     gd::defaultRef}; // Default reference when not indicated by user
 thread_local gd::Context GitAccess::ctx_{
     nullptr}; // Implicit context per thread
+thread_local GitAccess::Snapshot GitAccess::seen_; // Registry per thread
+thread_local Result<gd::Context> GitAccess::session_{gd_unexpected(
+    gd::ErrorType::MissingRepository, sNoSessionError)}; // Session per thread
+thread_local bool GitAccess::inSession_{false};
 
 static std::shared_ptr<spdlog::logger> sLogger{
     spdlog::null_logger_mt("No Logger")};
 
+/**
+ * Maps commits to their root trees, for point in time reads
+ * A commit and its root tree are immutable (content addressed), so a cached
+ * mapping never goes stale, and is valid across repositories.
+ * The cache is bounded, once full it is simply reset.
+ **/
+class RootTreeCache {
+public:
+  std::optional<git_oid> find(const git_oid &commitId) const noexcept {
+    std::shared_lock<std::shared_mutex> guard(access_);
+    if (auto itr{trees_.find(rawOid(commitId))}; itr != trees_.end())
+      return itr->second;
+    return std::nullopt;
+  }
+
+  void insert(const git_oid &commitId, const git_oid &treeId) noexcept {
+    std::lock_guard<std::shared_mutex> guard(access_);
+    if (trees_.size() >= sMaxEntries)
+      trees_.clear();
+    trees_.emplace(rawOid(commitId), treeId);
+  }
+
+private:
+  static constexpr size_t sMaxEntries{1 << 16};
+
+  mutable std::shared_mutex access_;
+  std::unordered_map<std::string, git_oid> trees_;
+};
+
+static RootTreeCache sRootTrees; // Commit to root tree mapping
+
 /**
  * Create a repository at a given path with a given name
  * The repository is owned by the cache and as long as the cache is alive (No
@@ -219,6 +709,29 @@ gd::ObjectUpdate::fromEntry(gd::Context &ctx,
   return std::move(elem);
 }
 
+Result<gd::ObjectUpdate>
+gd::ObjectUpdate::fromBlob(gd::Context &ctx,
+                           const std::filesystem::path &fullpath,
+                           const git_oid *blobId) noexcept {
+  auto odb = getOdb(*ctx.repo_);
+  if (!odb)
+    return gd_unexpected(std::move(odb));
+
+  auto header = getObjectHeader(*odb, blobId);
+  if (!header)
+    return gd_unexpected(std::move(header));
+
+  if (header->second != GIT_OBJECT_BLOB)
+    return gd_unexpected(gd::ErrorType::BadFile, "'"s + fullpath.string() + "' can't link a " +
+                                                     stringify(header->second));
+
+  ObjectUpdate blob{create(fullpath, GIT_FILEMODE_BLOB, &gd::ObjectUpdate::insert)};
+  git_oid_cpy(&blob.oid_, blobId);
+
+  sLogger->debug("Blob linked {}: {}", fullpath, blob.oid_);
+  return std::move(blob);
+}
+
 Result<gd::ObjectUpdate>
 gd::ObjectUpdate::remove(const std::filesystem::path &fullpath) noexcept {
   ObjectUpdate removed{create(fullpath, GIT_FILEMODE_UNREADABLE /* Ignored */,
@@ -292,6 +805,18 @@ gd::TreeCollector::insertEntry(gd::Context &ctx,
   return Result<void>();
 }
 
+Result<void>
+gd::TreeCollector::insertBlob(gd::Context &ctx,
+                              const std::filesystem::path &fullpath,
+                              const git_oid *blobId) noexcept {
+  auto blobResult = ObjectUpdate::fromBlob(ctx, fullpath, blobId);
+  if (!blobResult)
+    return gd_unexpected(std::move(blobResult));
+
+  insert(fullpath.parent_path().relative_path(), std::move(*blobResult));
+  return Result<void>();
+}
+
 Result<void>
 gd::TreeCollector::removeFile(gd::Context &ctx,
                               const std::filesystem::path &fullpath) noexcept {
@@ -306,14 +831,16 @@ gd::TreeCollector::removeFile(gd::Context &ctx,
 /// @return On success returns RAII flavoured git_tree which is the new root
 /// tree containing updates, otherwise an Error.
 Result<gd::tree_t> gd::TreeCollector::apply(gd::Context &ctx) noexcept {
-  git_oid const *treeOid = nullptr;
+  std::optional<git_oid> treeOid;
 
   for (const auto &[dir, objs] : dirObjs_) {
     bool isRootDir = dir.empty();
 
     sLogger->debug("Apply: Processing directory '/{}' ({} elements)", dir,
                    objs.size());
-    auto tree = getTreeRelativeToRoot(*ctx.repo_, ctx.tip_.root_, dir);
+    // A removed directory is rebuilt from its updates only
+    auto tree = removed(dir) ? Result<gd::tree_t>(nullptr)
+                             : getTreeRelativeToRoot(*ctx.repo_, ctx.tip_.root_, dir);
     if (!tree)
       return gd_unexpected(std::move(tree));
 
@@ -329,7 +856,7 @@ Result<gd::tree_t> gd::TreeCollector::apply(gd::Context &ctx) noexcept {
     if (auto parentDir = ObjectUpdate::createDir(dir, *bld); !parentDir) {
       return gd_unexpected(std::move(parentDir));
     } else {
-      treeOid = parentDir->oid();
+      treeOid = *parentDir->oid();
 
       if (!isRootDir) {
         insert(dir.parent_path(), std::move(*parentDir));
@@ -337,11 +864,11 @@ Result<gd::tree_t> gd::TreeCollector::apply(gd::Context &ctx) noexcept {
     }
   }
 
-  if (treeOid == nullptr)
+  if (!treeOid)
     return gd_unexpected(gd::ErrorType::EmptyCommit, "No updates made");
 
   dirObjs_.clear(); // Clear updates only on success
-  return getTree(*ctx.repo_, treeOid);
+  return getTree(*ctx.repo_, &*treeOid);
 }
 
 Result<gd::blob_t> gd::TreeCollector::getBlobByPath(
@@ -371,6 +898,63 @@ Result<gd::blob_t> gd::TreeCollector::getBlobByPath(
                        "No update found in uncommitted context");
 }
 
+gd::ObjectUpdate const *
+gd::TreeCollector::find(const std::filesystem::path &fullpath) const noexcept {
+  auto dirObjsIdx = dirObjs_.find(fullpath.parent_path().relative_path());
+  if (dirObjsIdx == dirObjs_.end())
+    return nullptr;
+
+  const auto &[_, objList] = *dirObjsIdx;
+  auto name = fullpath.filename();
+  for (auto obj = objList.rbegin(); obj != objList.rend(); ++obj)
+    if (obj->name() == name)
+      return &*obj;
+
+  return nullptr;
+}
+
+bool gd::TreeCollector::removed(const std::filesystem::path &dir) const noexcept {
+  for (auto path = dir.relative_path(); !path.empty(); path = path.parent_path())
+    if (auto update = find(path); update && update->isDelete())
+      return true;
+  return false;
+}
+
+std::map<std::string, gd::ObjectUpdate>
+gd::TreeCollector::pending(const std::filesystem::path &dir) const noexcept {
+  std::map<std::string, ObjectUpdate> latest;
+  if (auto dirObjsIdx = dirObjs_.find(dir); dirObjsIdx != dirObjs_.end())
+    for (const auto &obj : dirObjsIdx->second)
+      latest.insert_or_assign(obj.name(), obj);
+
+  return latest;
+}
+
+std::set<std::string>
+gd::TreeCollector::pendingDirs(const std::filesystem::path &dir) const noexcept {
+  std::set<std::string> dirs;
+  auto depth = std::distance(dir.begin(), dir.end());
+  for (const auto &[updated, _] : dirObjs_) {
+    if (std::distance(updated.begin(), updated.end()) <= depth)
+      break; // Longer paths first, no deeper directories are left
+
+    auto [dirEnd, updatedItr] = std::mismatch(dir.begin(), dir.end(), updated.begin());
+    if (dirEnd == dir.end())
+      dirs.insert(updatedItr->string());
+  }
+  return dirs;
+}
+
+std::map<std::filesystem::path, gd::ObjectUpdate>
+gd::TreeCollector::changes() const noexcept {
+  std::map<std::filesystem::path, ObjectUpdate> latest;
+  for (const auto &[dir, objs] : dirObjs_)
+    for (const auto &obj : objs)
+      latest.insert_or_assign(dir / obj.name(), obj);
+
+  return latest;
+}
+
 /*******************************************************************************
  *                             internal::context
  *           Context for chaining calls, namely repository and branch
@@ -394,8 +978,9 @@ git_oid const *gd::Context::getCommitId() const noexcept {
  *******************************************************************************/
 gd::internal::Node::Node(Node &&other) noexcept
     : commit_(std::move(other.commit_)), root_(std::move(other.root_)),
-      commitId_(std::move(other.commitId_)) {
+      commitId_(std::move(other.commitId_)), generation_(other.generation_) {
   other.commitId_ = nullptr;
+  other.generation_ = 0;
 }
 
 /// @brief Move assignment operator
@@ -406,6 +991,7 @@ gd::internal::Node &gd::internal::Node::operator=(Node &&other) noexcept {
     commitId_ = std::move(other.commitId_);
     commit_ = std::move(other.commit_);
     root_ = std::move(other.root_);
+    generation_ = std::exchange(other.generation_, 0);
   }
   return *this;
 }
@@ -413,19 +999,15 @@ gd::internal::Node &gd::internal::Node::operator=(Node &&other) noexcept {
 /// @brief Initialize
 /// @param ctx the context used to access the repository
 /// @return On success a context for chaining, otherwise an Error
+///
+/// The tip's commit and root tree are looked up only when the tip moved since
+/// they were last loaded (see `Node::rebase`)
 Result<gd::Context> gd::internal::Node::init(gd::Context &&ctx) noexcept {
-  if (auto commit = getCommitByRef(*ctx.repo_, ctx.ref_); !commit) {
-    return gd_unexpected(std::move(commit));
-  } else {
-    ctx.tip_.commit_ = std::move(*commit);
-  }
-
-  ctx.tip_.commitId_ = git_commit_id(ctx.tip_.commit_);
-
-  if (auto tree = getTreeOfCommit(*ctx.repo_, ctx.tip_.commit_); !tree) {
-    return gd_unexpected(std::move(tree));
-  } else {
-    ctx.tip_.root_ = std::move(*tree);
+  if (auto rebased = ctx.tip_.rebase(ctx); !rebased) {
+    // Reported as a revision not found, i.e. an unknown branch
+    if (auto commit = getCommitByRef(*ctx.repo_, ctx.ref_); !commit)
+      return gd_unexpected(std::move(commit));
+    return gd_unexpected(std::move(rebased));
   }
   return std::move(ctx);
 }
@@ -453,35 +1035,64 @@ Result<void> gd::internal::Node::update(const gd::Context &ctx,
   commitId_ = git_commit_id(*commit);
   commit_ = std::move(*commit);
   root_ = std::move(*tree);
+  generation_ = 0;
 
   sLogger->debug("Tip of '{}' updated to {}", ctx.ref_, *commitId);
   return Result<void>();
 }
 
-Result<void> gd::internal::Node::rebase(const gd::Context &ctx) noexcept {
-
-  auto commitId = referenceCommit(*ctx.repo_, ctx.ref_);
-  if (!commitId)
-    return gd_unexpected(std::move(commitId));
+/// @brief Syncs the node with the tip of the context's reference
+/// @param refresh Read the reference from disk, otherwise the tip last known
+/// in process is used (see `TipTable`)
+/// @return nothing on success, otherwise an Error
+///
+/// The commit is loaded only when the tip moved (or the node is new)
+Result<void> gd::internal::Node::rebase(const gd::Context &ctx,
+                                        bool refresh) noexcept {
+  auto seen = refresh ? sTips.refresh(*ctx.repo_, ctx.ref_)
+                      : sTips.seen(*ctx.repo_, ctx.ref_);
+  if (!seen)
+    return gd_unexpected(std::move(seen));
+
+  if (generation_ != seen->generation_ &&
+      (commitId_ == nullptr || !git_oid_equal(&seen->id_, commitId_))) {
+    if (auto loaded = sTips.loaded(*ctx.repo_, ctx.ref_, seen->generation_)) {
+      git_commit *commit{nullptr};
+      git_tree *root{nullptr};
+      if (git_commit_dup(&commit, loaded->commit_) != 0 ||
+          git_tree_dup(&root, loaded->root_) != 0) {
+        git_commit_free(commit);
+        return gd_unexpected();
+      }
+      commit_ = commit;
+      root_ = root;
+      commitId_ = git_commit_id(commit_);
+    } else {
+      if (auto updated = update(ctx, &seen->id_); !updated)
+        return updated;
+      sTips.keep(*ctx.repo_, ctx.ref_, seen->generation_, commit_, root_);
+    }
+  }
 
-  return update(ctx, *commitId);
+  generation_ = seen->generation_;
+  return Result<void>();
 }
 
-Result<git_oid const *>
-gd::internal::Node::tip(const gd::Context &ctx) noexcept {
-  auto commitId = referenceCommit(*ctx.repo_, ctx.ref_);
-  if (!commitId)
-    return gd_unexpected(std::move(commitId));
+Result<git_oid> gd::internal::Node::tip(const gd::Context &ctx) noexcept {
+  auto seen = sTips.seen(*ctx.repo_, ctx.ref_);
+  if (!seen)
+    return gd_unexpected(std::move(seen));
 
-  return *commitId;
+  return seen->id_;
 }
 
 Result<bool> gd::internal::Node::isTip(const gd::Context &ctx) noexcept {
-  auto commitId = referenceCommit(*ctx.repo_, ctx.ref_);
-  if (!commitId)
-    return gd_unexpected(std::move(commitId));
+  auto seen = sTips.seen(*ctx.repo_, ctx.ref_);
+  if (!seen)
+    return gd_unexpected(std::move(seen));
 
-  return commitId_ != nullptr && git_oid_cmp(*commitId, commitId_) == 0;
+  return generation_ == seen->generation_ ||
+         (commitId_ != nullptr && git_oid_equal(&seen->id_, commitId_));
 }
 
 /*******************************************************************************
@@ -510,6 +1121,183 @@ Result<gd::Context> gd::selectRepository(const std::filesystem::path &fullpath,
   return createRepo(fullpath, name);
 }
 
+Result<gd::Context> gd::selectRepository(const std::filesystem::path &fullpath,
+                                         const std::vector<gd::Prefetch> &warmUp,
+                                         const std::string &name) noexcept {
+  auto ctx = selectRepository(fullpath, name);
+  if (!ctx)
+    return ctx;
+
+  std::vector<std::future<Result<size_t>>> loading;
+  for (const auto &what : warmUp)
+    loading.push_back(prefetch(*ctx, what));
+
+  for (size_t i = 0; i < loading.size(); ++i)
+    if (auto loaded = loading[i].get(); !loaded)
+      sLogger->warn("Warm up of '/{}' failed: {}", warmUp[i].prefix_, loaded.error()._msg);
+
+  return ctx;
+}
+
+namespace {
+constexpr size_t sMiB = 1024 * 1024;
+
+/// @brief libgit2 can't report every setting back, those applied are tracked here,
+///        starting with libgit2's own defaults
+struct Tuning {
+  std::mutex lock_;
+  gd::RepositoryOptions applied_ = gd::RepositoryOptions::of(gd::Profile::Default);
+};
+static Tuning sTuning;
+
+/// @brief Reads back what libgit2 reports, the rest is what was last applied
+gd::RepositoryOptions effectiveTuning() noexcept {
+  auto effective = sTuning.applied_;
+
+  ssize_t current = 0, allowed = 0;
+  if (git_libgit2_opts(GIT_OPT_GET_CACHED_MEMORY, &current, &allowed) == 0)
+    effective.cacheMaxSize_ = allowed;
+
+  size_t value = 0;
+  if (git_libgit2_opts(GIT_OPT_GET_MWINDOW_SIZE, &value) == 0)
+    effective.mwindowSize_ = value;
+  if (git_libgit2_opts(GIT_OPT_GET_MWINDOW_MAPPED_LIMIT, &value) == 0)
+    effective.mwindowMappedLimit_ = value;
+
+  return effective;
+}
+} // namespace
+
+gd::RepositoryOptions gd::RepositoryOptions::of(gd::Profile profile) noexcept {
+  // Every profile sets every field, starting from libgit2's defaults on 64 bit platforms,
+  // so switching profiles doesn't inherit settings of the former one
+  RepositoryOptions options{.cacheMaxSize_ = 256 * sMiB,
+                            .commitCacheLimit_ = 4096,
+                            .treeCacheLimit_ = 4096,
+                            .blobCacheLimit_ = 0,
+                            .mwindowSize_ = 1024 * sMiB,
+                            .mwindowMappedLimit_ = 8192 * sMiB,
+                            .strictObjectCreation_ = true,
+                            .fsync_ = false,
+                            .verifyHashes_ = true,
+                            .warmUp_ = {}};
+
+  switch (profile) {
+  case Profile::ReadHeavy:
+    options.cacheMaxSize_ = 1024 * sMiB;
+    options.commitCacheLimit_ = 64 * 1024;
+    options.treeCacheLimit_ = 1 * sMiB;
+    options.blobCacheLimit_ = 64 * 1024;
+    options.mwindowMappedLimit_ = 32768 * sMiB;
+    break;
+  case Profile::WriteHeavy:
+    options.cacheMaxSize_ = 64 * sMiB;
+    options.treeCacheLimit_ = 64 * 1024;
+    options.strictObjectCreation_ = false;
+    break;
+  case Profile::LowMemory:
+    options.cacheMaxSize_ = 16 * sMiB;
+    options.commitCacheLimit_ = 1024;
+    options.treeCacheLimit_ = 1024;
+    options.mwindowSize_ = 32 * sMiB;
+    options.mwindowMappedLimit_ = 256 * sMiB;
+    break;
+  case Profile::Durable:
+    options.fsync_ = true;
+    break;
+  case Profile::Default:
+    break;
+  }
+  return options;
+}
+
+namespace {
+/// @brief Sets the options' set fields, recording those libgit2 can't report back
+/// @return On success nothing, otherwise the Error of the first setting rejected, later ones are not set
+Result<void> setTuning(const gd::RepositoryOptions &options, gd::RepositoryOptions &applied) noexcept {
+  if (options.cacheMaxSize_) {
+    if (git_libgit2_opts(GIT_OPT_SET_CACHE_MAX_SIZE, *options.cacheMaxSize_) < 0)
+      return gd_unexpected();
+    applied.cacheMaxSize_ = options.cacheMaxSize_;
+  }
+
+  for (auto [limit, type, record] : {
+           std::tuple{&options.commitCacheLimit_, GIT_OBJECT_COMMIT, &applied.commitCacheLimit_},
+           std::tuple{&options.treeCacheLimit_, GIT_OBJECT_TREE, &applied.treeCacheLimit_},
+           std::tuple{&options.blobCacheLimit_, GIT_OBJECT_BLOB, &applied.blobCacheLimit_}}) {
+    if (!*limit)
+      continue;
+    if (git_libgit2_opts(GIT_OPT_SET_CACHE_OBJECT_LIMIT, type, **limit) < 0)
+      return gd_unexpected();
+    *record = *limit;
+  }
+
+  if (options.mwindowSize_ && git_libgit2_opts(GIT_OPT_SET_MWINDOW_SIZE, *options.mwindowSize_) < 0)
+    return gd_unexpected();
+  if (options.mwindowMappedLimit_ &&
+      git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, *options.mwindowMappedLimit_) < 0)
+    return gd_unexpected();
+
+  if (options.strictObjectCreation_) {
+    if (git_libgit2_opts(GIT_OPT_ENABLE_STRICT_OBJECT_CREATION, int(*options.strictObjectCreation_)) < 0)
+      return gd_unexpected();
+    applied.strictObjectCreation_ = options.strictObjectCreation_;
+  }
+
+  if (options.fsync_) {
+    if (git_libgit2_opts(GIT_OPT_ENABLE_FSYNC_GITDIR, int(*options.fsync_)) < 0)
+      return gd_unexpected();
+    applied.fsync_ = options.fsync_;
+  }
+
+  if (options.verifyHashes_) {
+    if (git_libgit2_opts(GIT_OPT_ENABLE_STRICT_HASH_VERIFICATION, int(*options.verifyHashes_)) < 0)
+      return gd_unexpected();
+    applied.verifyHashes_ = options.verifyHashes_;
+  }
+
+  return Result<void>();
+}
+} // namespace
+
+Result<gd::RepositoryOptions> gd::tune(const gd::RepositoryOptions &options) noexcept {
+  std::lock_guard guard(sTuning.lock_);
+
+  // Settings are applied all or none, a rejected one restores those set before it
+  auto before = effectiveTuning();
+  if (auto set = setTuning(options, sTuning.applied_); !set) {
+    if (auto restored = setTuning(before, sTuning.applied_); !restored)
+      sLogger->warn("Tuning not restored: {}", restored.error()._msg);
+    return gd_unexpected(std::move(set));
+  }
+
+  auto effective = effectiveTuning();
+  sLogger->debug("Tuned: cache {}B (commit {}B, tree {}B, blob {}B), mwindow {}B mapped {}B, strict {}, fsync {}, verify {}",
+                 *effective.cacheMaxSize_, *effective.commitCacheLimit_, *effective.treeCacheLimit_,
+                 *effective.blobCacheLimit_, *effective.mwindowSize_, *effective.mwindowMappedLimit_,
+                 *effective.strictObjectCreation_, *effective.fsync_, *effective.verifyHashes_);
+  return effective;
+}
+
+gd::RepositoryOptions gd::tuning() noexcept {
+  std::lock_guard guard(sTuning.lock_);
+  return effectiveTuning();
+}
+
+Result<gd::Context> gd::selectRepository(const std::filesystem::path &fullpath,
+                                         const gd::RepositoryOptions &options,
+                                         const std::string &name) noexcept {
+  if (auto tuned = tune(options); !tuned)
+    return gd_unexpected(std::move(tuned));
+
+  return selectRepository(fullpath, options.warmUp_, name);
+}
+
+Result<gd::Context> gd::selectRepository(const std::filesystem::path &fullpath, gd::Profile profile,
+                                         const std::string &name) noexcept {
+  return selectRepository(fullpath, RepositoryOptions::of(profile), name);
+}
+
 /// @brief Changes the context branch
 /// @param ctx The context used to access the repository
 /// @param name Branch name
@@ -565,6 +1353,25 @@ Result<gd::Context> gd::ni::rm(gd::Context &&ctx,
   return std::move(ctx);
 }
 
+/// @brief Adds a file by linking an existing blob, content isn't resupplied nor rehashed
+/// @param ctx The context used to access the repository
+/// @param fullpath Full path of the file, including filename
+/// @param blobId The blob's `git_oid`
+/// @return On success, the context for continued repository access, otherwise
+/// an Error
+Result<gd::Context> gd::ni::addById(gd::Context &&ctx,
+                                    const std::filesystem::path &fullpath,
+                                    const git_oid &blobId) noexcept {
+  if (not ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  if (auto res = ctx.updates_.insertBlob(ctx, fullpath, &blobId); !res)
+    return gd_unexpected(std::move(res));
+
+  sLogger->debug("Add Blob '{}' by id {}", fullpath, blobId);
+  return std::move(ctx);
+}
+
 /// @brief Moves a file from on `fullpath` to `toFullPath`
 /// @param ctx The context used to access the repository
 /// @param fullpath Original path of the moved file, including filename.
@@ -591,28 +1398,414 @@ Result<gd::Context> gd::ni::mv(gd::Context &&ctx, const std::string &fullpath,
   return std::move(ctx);
 }
 
-/// @brief Commits collected updates
-/// @param ctx The context used to access the repository
-/// @param message The commit message
-/// @return  On success propagates the context, otherwise an Error
-Result<gd::Context> gd::ni::commit(gd::Context &&ctx, const std::string &author,
-                                   const std::string &email,
-                                   const std::string &message) noexcept {
-  if (ctx.updates_.empty())
-    return gd_unexpected(gd::ErrorType::EmptyCommit, "Nothing to commit");
+namespace {
+constexpr char const *sIndexRoot = ".gd/index";
+
+/// @brief The bytes of a (lower case) hex string, as written by `toHex`
+///        Keys and paths are hex encoded into entry names, any byte is allowed and their order is kept
+/// @return On success the bytes, otherwise an Error (odd length, or not a hex digit)
+Result<std::string> fromHex(const std::string &hex) noexcept {
+  auto value = [](char c) {
+    return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+  };
+  if (hex.size() % 2 != 0)
+    return gd_unexpected(gd::ErrorType::BadFile, "Malformed hex '" + hex + "'");
+
+  std::string raw;
+  raw.reserve(hex.size() / 2);
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    auto high = value(hex[i]), low = value(hex[i + 1]);
+    if (high < 0 || low < 0)
+      return gd_unexpected(gd::ErrorType::BadFile, "Malformed hex '" + hex + "'");
+    raw += static_cast<char>(high << 4 | low);
+  }
+  return raw;
+}
 
-  auto newRoot = ctx.updates_.apply(ctx);
-  if (!newRoot)
-    return gd_unexpected(std::move(newRoot));
+std::filesystem::path indexPath(const gd::Index &index, const std::string &key,
+                                const std::filesystem::path &fullpath) noexcept {
+  return std::filesystem::path(sIndexRoot) / index.name_ / toHex(key) / toHex(fullpath.string());
+}
 
-  auto commiter = getSignature(author, email);
-  if (!commiter)
-    return gd_unexpected(std::move(commiter));
+/// @brief Whether a file is indexed by `index`, files under .gd (the indexes themselves) never are
+bool isIndexed(const gd::Index &index, const std::filesystem::path &fullpath) noexcept {
+  if (fullpath.empty() || *fullpath.begin() == ".gd")
+    return false;
 
-  git_commit const *parents[1]{ctx.tip_.commit_};
+  auto prefix = index.prefix_.relative_path();
+  if (!prefix.empty() && !prefix.has_filename())
+    prefix = prefix.parent_path();
 
-  git_oid commitId;
-  {
+  return std::mismatch(prefix.begin(), prefix.end(), fullpath.begin(), fullpath.end()).first == prefix.end();
+}
+
+/// @brief Files affected by updates, full path -> (blob before, blob after), a missing blob is a missing file
+using ChangedFiles = std::map<std::filesystem::path, std::pair<std::optional<git_oid>, std::optional<git_oid>>>;
+
+/// @brief Adds the files of a tree, recursively, as either the before or after side of a change
+Result<void> filesOf(git_repository *repo, const git_oid &treeId, const std::filesystem::path &dir,
+                     bool after, ChangedFiles &changed) noexcept {
+  auto tree = getTree(repo, &treeId);
+  if (!tree)
+    return gd_unexpected(std::move(tree));
+
+  for (size_t i = 0; i < git_tree_entrycount(*tree); ++i) {
+    auto entry = git_tree_entry_byindex(*tree, i);
+    auto fullpath = dir / git_tree_entry_name(entry);
+    if (git_tree_entry_type(entry) == GIT_OBJECT_TREE) {
+      if (auto res = filesOf(repo, *git_tree_entry_id(entry), fullpath, after, changed); !res)
+        return res;
+    } else {
+      auto &[before, now] = changed[fullpath];
+      (after ? now : before) = *git_tree_entry_id(entry);
+    }
+  }
+  return Result<void>();
+}
+
+/// @brief The files affected by the context's updates, updated (moved or deleted) directories are expanded
+Result<ChangedFiles> changedFiles(const gd::Context &ctx) noexcept {
+  ChangedFiles changed;
+  for (const auto &[fullpath, update] : ctx.updates_.changes()) {
+    if (*fullpath.begin() == ".gd")
+      continue;
+
+    auto entry = ctx.tip_.root_ ? getTreeEntry(ctx.tip_.root_, fullpath.string()) : Result<gd::entry_t>(nullptr);
+    if (!!entry && *entry) {
+      if (git_tree_entry_type(*entry) == GIT_OBJECT_TREE) {
+        if (auto res = filesOf(*ctx.repo_, *git_tree_entry_id(*entry), fullpath, false, changed); !res)
+          return gd_unexpected(std::move(res));
+      } else {
+        changed[fullpath].first = *git_tree_entry_id(*entry);
+      }
+    }
+
+    if (update.isDelete())
+      continue;
+
+    if (update.mod() == GIT_FILEMODE_TREE) {
+      if (auto res = filesOf(*ctx.repo_, *update.oid(), fullpath, true, changed); !res)
+        return gd_unexpected(std::move(res));
+    } else {
+      changed[fullpath].second = *update.oid();
+    }
+  }
+  return changed;
+}
+
+/// @brief Whether an index entry is present, after the context's updates
+bool hasEntry(const gd::Context &ctx, const std::filesystem::path &fullpath) noexcept {
+  if (auto update = ctx.updates_.find(fullpath))
+    return !update->isDelete();
+
+  return ctx.tip_.root_ && !!getTreeEntry(ctx.tip_.root_, fullpath.string());
+}
+
+Result<std::set<std::string>> keysOf(git_repository *repo, const gd::Index &index,
+                                     const std::filesystem::path &fullpath, const git_oid &blobId) noexcept {
+  auto blob = getBlobById(repo, &blobId);
+  if (!blob)
+    return gd_unexpected(std::move(blob));
+
+  auto keys = index.keys_(fullpath, std::string(static_cast<const char *>(git_blob_rawcontent(*blob)),
+                                                git_blob_rawsize(*blob)));
+  return std::set<std::string>(std::make_move_iterator(keys.begin()), std::make_move_iterator(keys.end()));
+}
+
+/// @brief Collects the index entry updates of changed files: keys no longer held are removed, held keys
+///        are (re)linked to the file's current blob
+Result<void> updateIndex(gd::Context &ctx, const gd::Index &index, const ChangedFiles &changed) noexcept {
+  for (const auto &[fullpath, change] : changed) {
+    const auto &[before, after] = change;
+    if (!isIndexed(index, fullpath) ||
+        (before && after && git_oid_equal(&*before, &*after)) || (!before && !after))
+      continue;
+
+    std::set<std::string> oldKeys, newKeys;
+    if (before) {
+      auto keys = keysOf(*ctx.repo_, index, fullpath, *before);
+      if (!keys)
+        return gd_unexpected(std::move(keys));
+      oldKeys = std::move(*keys);
+    }
+    if (after) {
+      auto keys = keysOf(*ctx.repo_, index, fullpath, *after);
+      if (!keys)
+        return gd_unexpected(std::move(keys));
+      newKeys = std::move(*keys);
+    }
+
+    for (const auto &key : oldKeys)
+      if (auto entry = indexPath(index, key, fullpath); !newKeys.contains(key) && hasEntry(ctx, entry))
+        if (auto res = ctx.updates_.removeFile(ctx, entry); !res)
+          return res;
+
+    for (const auto &key : newKeys)
+      if (auto res = ctx.updates_.insertBlob(ctx, indexPath(index, key, fullpath), &*after); !res)
+        return res;
+  }
+  return Result<void>();
+}
+
+/// @brief Maintains the repository's indexes from the context's updates, ahead of their commit
+Result<void> updateIndexes(gd::Context &ctx) noexcept {
+  auto indexes = sIndexes.of(*ctx.repo_);
+  if (indexes.empty())
+    return Result<void>();
+
+  auto changed = changedFiles(ctx);
+  if (!changed)
+    return gd_unexpected(std::move(changed));
+
+  for (const auto &index : indexes)
+    if (auto res = updateIndex(ctx, index, *changed); !res)
+      return res;
+
+  return Result<void>();
+}
+} // namespace
+
+Result<size_t> gd::observeCommits(const gd::Context &ctx, gd::CommitObserver observer) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  return sObservers.add(*ctx.repo_, std::move(observer));
+}
+
+void gd::removeObserver(size_t id) noexcept { sObservers.remove(id); }
+
+/// @brief Keeps a manifest of every later commit to the repository
+/// @param ctx The context used to access the repository
+/// @return On success the context, otherwise an Error
+Result<gd::Context> gd::ni::keepManifests(gd::Context &&ctx) noexcept {
+  if (not ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  sManifests.add(*ctx.repo_);
+  return std::move(ctx);
+}
+
+/// @brief Keeps a changed-path filter of every later commit to the repository
+/// @param ctx The context used to access the repository
+/// @return On success the context, otherwise an Error
+Result<gd::Context> gd::ni::keepPathFilters(gd::Context &&ctx) noexcept {
+  if (not ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  sPathFilters.add(*ctx.repo_);
+  return std::move(ctx);
+}
+
+/// @brief Keeps the metadata of every later commit to the repository in its commit index
+/// @param ctx The context used to access the repository
+/// @return On success the context, otherwise an Error
+Result<gd::Context> gd::ni::keepCommitIndex(gd::Context &&ctx) noexcept {
+  if (not ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  sCommitIndexes.add(*ctx.repo_);
+  return std::move(ctx);
+}
+
+/// @brief Starts recording the files read, validated on commit
+/// @param ctx The context used to access the repository
+/// @return On success the context, otherwise an Error
+Result<gd::Context> gd::ni::serializable(gd::Context &&ctx) noexcept {
+  if (not ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  if (!ctx.reads_)
+    ctx.reads_.emplace();
+  return std::move(ctx);
+}
+
+/// @brief Registers an index, and builds it from the tip's files if it isn't stored at the tip
+/// @param ctx The context used to access the repository
+/// @param index The index definition
+/// @return On success the context, holding the initial index entries as updates, otherwise an Error
+Result<gd::Context> gd::ni::createIndex(gd::Context &&ctx, const gd::Index &index) noexcept {
+  if (not ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  if (index.name_.empty() || index.name_.find('/') != std::string::npos || !index.keys_)
+    return gd_unexpected(gd::ErrorType::Application, "Invalid index '" + index.name_ + "'");
+
+  // Registered once built, a failed build leaves no index to maintain
+  auto stored = getTreeRelativeToRoot(*ctx.repo_, ctx.tip_.root_, std::filesystem::path(sIndexRoot) / index.name_);
+  if (!stored)
+    return gd_unexpected(std::move(stored));
+  if (*stored) {
+    sIndexes.add(*ctx.repo_, index);
+    sLogger->debug("Index '{}' registered", index.name_);
+    return std::move(ctx);
+  }
+
+  ChangedFiles files;
+  std::optional<git_oid> treeId;
+  if (index.prefix_.relative_path().empty()) {
+    if (ctx.tip_.root_)
+      treeId = *git_tree_id(ctx.tip_.root_);
+  } else if (auto tree = getTreeRelativeToRoot(*ctx.repo_, ctx.tip_.root_, index.prefix_.relative_path()); !tree) {
+    return gd_unexpected(std::move(tree));
+  } else if (*tree) {
+    treeId = *git_tree_id(*tree);
+  }
+
+  if (treeId)
+    if (auto res = filesOf(*ctx.repo_, *treeId, index.prefix_.relative_path(), true, files); !res)
+      return gd_unexpected(std::move(res));
+
+  if (auto res = updateIndex(ctx, index, files); !res)
+    return gd_unexpected(std::move(res));
+
+  sIndexes.add(*ctx.repo_, index);
+  sLogger->debug("Index '{}' created from {} files", index.name_, files.size());
+  return std::move(ctx);
+}
+
+Result<std::vector<gd::WalkItem>> gd::lookup(const gd::Context &ctx, const std::string &index,
+                                             const std::string &key) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  std::vector<WalkItem> found;
+  auto keyDir = std::filesystem::path(sIndexRoot) / index / toHex(key);
+  auto tree = getTreeRelativeToRoot(*ctx.repo_, ctx.tip_.root_, keyDir);
+  if (!tree)
+    return gd_unexpected(std::move(tree));
+  if (!*tree)
+    return found;
+
+  for (size_t i = 0; i < git_tree_entrycount(*tree); ++i) {
+    auto entry = git_tree_entry_byindex(*tree, i);
+    auto key = fromHex(git_tree_entry_name(entry));
+    if (!key)
+      return gd_unexpected(std::move(key));
+    found.push_back({std::move(*key), *git_tree_entry_id(entry), git_tree_entry_filemode(entry), *ctx.repo_});
+  }
+  return found;
+}
+
+namespace {
+/// @brief The oid of a file or directory in a tree
+/// @return On success the oid (the tree's own for an empty path), or nullopt when absent, otherwise an Error
+Result<std::optional<git_oid>> idAt(const git_tree *root, const std::string &path) noexcept {
+  if (path.empty())
+    return *git_tree_id(root);
+
+  git_tree_entry *raw{nullptr};
+  int result = git_tree_entry_bypath(&raw, root, path.c_str());
+  if (result == GIT_ENOTFOUND)
+    return std::nullopt;
+  if (result != GIT_OK)
+    return gd_unexpected();
+
+  gd::entry_t entry{raw};
+  return *git_tree_entry_id(entry);
+}
+
+/// @brief Validates the files read by a serializable context against the tip
+/// of its reference, and moves the context to that tip. The files it updates
+/// are validated too, they may have been read by other means than `read`
+/// (i.e. `patchField`, `readRange`)
+/// @return On success nothing, otherwise an Error (Conflict when a file read
+/// or updated changed)
+Result<void> validateReads(gd::Context &ctx) noexcept {
+  auto seen = sTips.refresh(*ctx.repo_, ctx.ref_);
+  if (!seen && !ctx.getCommitId()) // Nothing was committed yet
+    return Result<void>();
+  if (!seen)
+    return gd_unexpected(std::move(seen));
+  if (ctx.getCommitId() && git_oid_equal(&seen->id_, ctx.getCommitId()))
+    return Result<void>();
+
+  auto commit = getCommitById(*ctx.repo_, &seen->id_);
+  if (!commit)
+    return gd_unexpected(std::move(commit));
+  auto tree = getTreeOfCommit(*ctx.repo_, *commit);
+  if (!tree)
+    return gd_unexpected(std::move(tree));
+
+  auto changed = [](const std::optional<git_oid> &id, const std::optional<git_oid> &was) {
+    return id.has_value() != was.has_value() || (id && !git_oid_equal(&*id, &*was));
+  };
+
+  for (const auto &[path, read] : *ctx.reads_) {
+    auto id = idAt(*tree, path);
+    if (!id)
+      return gd_unexpected(std::move(id));
+    if (changed(*id, read))
+      return gd_unexpected(gd::ErrorType::Conflict,
+                           "'" + path + "' changed since it was read");
+  }
+
+  for (const auto &[fullpath, _] : ctx.updates_.changes()) {
+    auto path = fullpath.relative_path().string();
+    auto id = idAt(*tree, path);
+    if (!id)
+      return gd_unexpected(std::move(id));
+
+    std::optional<git_oid> was;
+    if (ctx.tip_.root_) {
+      auto found = idAt(ctx.tip_.root_, path);
+      if (!found)
+        return gd_unexpected(std::move(found));
+      was = *found;
+    }
+    if (changed(*id, was))
+      return gd_unexpected(gd::ErrorType::Conflict,
+                           "'" + path + "' changed since the transaction began");
+  }
+
+  if (auto updated = ctx.update(&seen->id_); !updated)
+    return updated;
+  ctx.tip_.generation_ = seen->generation_;
+  return Result<void>();
+}
+} // namespace
+
+/// @brief Commits collected updates
+/// @param ctx The context used to access the repository
+/// @param message The commit message
+/// @return  On success propagates the context, otherwise an Error
+Result<gd::Context> gd::ni::commit(gd::Context &&ctx, const std::string &author,
+                                   const std::string &email,
+                                   const std::string &message) noexcept {
+  if (ctx.updates_.empty())
+    return gd_unexpected(gd::ErrorType::EmptyCommit, "Nothing to commit");
+
+  // Moves to the tip, indexes are then updated from the tip committed on
+  if (ctx.reads_)
+    if (auto valid = validateReads(ctx); !valid)
+      return gd_unexpected(std::move(valid));
+
+  if (auto indexed = updateIndexes(ctx); !indexed)
+    return gd_unexpected(std::move(indexed));
+
+  std::vector<std::filesystem::path> changed;
+  bool manifest = sManifests.contains(*ctx.repo_);
+  bool filter = sPathFilters.contains(*ctx.repo_);
+  if (manifest || filter)
+    for (const auto &[path, _] : ctx.updates_.changes())
+      changed.push_back(path);
+
+  std::optional<git_oid> parentId;
+  if (ctx.getCommitId())
+    parentId = *ctx.getCommitId();
+
+  auto newRoot = ctx.updates_.apply(ctx);
+  if (!newRoot)
+    return gd_unexpected(std::move(newRoot));
+
+  auto commiter = getSignature(author, email);
+  if (!commiter)
+    return gd_unexpected(std::move(commiter));
+
+  git_commit const *parents[1]{ctx.tip_.commit_};
+
+  git_oid commitId;
+  uint64_t generation;
+  {
     static std::mutex commitAccess;
 
     /// The only contention point in need of serialization is updates to the
@@ -628,15 +1821,39 @@ Result<gd::Context> gd::ni::commit(gd::Context &&ctx, const std::string &author,
                                    1,                /* parent count     */
                                    parents);         /* parents          */
 
+    // The tip moved after the reads were validated (i.e. by another process), they are stale
+    if (result == GIT_EMODIFIED && ctx.reads_)
+      return gd_unexpected(gd::ErrorType::Conflict, "'" + ctx.ref_ + "' moved while committing");
     if (result != 0)
       return gd_unexpected();
+    generation = sTips.moved(*ctx.repo_, ctx.ref_, commitId);
   }
 
   if (auto res = ctx.update(&commitId); !res)
     return gd_unexpected(std::move(res));
+  ctx.tip_.generation_ = generation;
+  sTips.keep(*ctx.repo_, ctx.ref_, generation, ctx.tip_.commit_, ctx.tip_.root_);
+  if (ctx.reads_)
+    ctx.reads_->clear();
 
   sLogger->debug("Committed on ref {} {}({}): {}", ctx.ref_, commitId, author,
                  message);
+
+  // The commit stands without its manifest (the next one is then built from the entire tree), its filter
+  // or its index record
+  if (manifest)
+    if (auto written = internal::writeManifest(*ctx.repo_, parentId ? &*parentId : nullptr, commitId,
+                                               ctx.tip_.root_, changed); !written)
+      sLogger->warn("No manifest for {}: {}", commitId, written.error()._msg);
+  if (filter)
+    if (auto written = internal::writePathFilter(*ctx.repo_, commitId, changed); !written)
+      sLogger->warn("No path filter for {}: {}", commitId, written.error()._msg);
+  if (sCommitIndexes.contains(*ctx.repo_))
+    if (auto written = internal::appendCommit(*ctx.repo_, commitId, parentId ? &*parentId : nullptr, ctx.ref_,
+                                              *commiter, message); !written)
+      sLogger->warn("{} not in the commit index: {}", commitId, written.error()._msg);
+
+  sObservers.notify(ctx);
   return std::move(ctx);
 }
 
@@ -645,6 +1862,8 @@ Result<gd::Context> gd::ni::commit(gd::Context &&ctx, const std::string &author,
 /// @return On success the context for continued chaining, otherwise an error.
 Result<gd::Context> gd::ni::rollback(gd::Context &&ctx) noexcept {
   ctx.updates_.clean();
+  if (ctx.reads_)
+    ctx.reads_->clear();
   return std::move(ctx);
 }
 
@@ -664,6 +1883,7 @@ Result<gd::Context> gd::ni::createBranch(gd::Context &&ctx,
   auto branchRef = createBranch(*ctx.repo_, name, ctx.tip_.commit_);
   if (!branchRef)
     return gd_unexpected(std::move(branchRef));
+  sTips.moved(*ctx.repo_, git_reference_name(*branchRef), *git_reference_target(*branchRef));
 
   sLogger->debug("Branch '{}' created", name);
   return std::move(ctx);
@@ -679,6 +1899,7 @@ Result<gd::Context> gd::ni::createBranch(gd::Context &&ctx,
   auto branchRef = createBranch(*ctx.repo_, name, ctx.tip_.commit_);
   if (!branchRef)
     return gd_unexpected(std::move(branchRef));
+  sTips.moved(*ctx.repo_, git_reference_name(*branchRef), *git_reference_target(*branchRef));
 
   sLogger->debug("Branch '{}' created", name);
   return std::move(ctx);
@@ -700,6 +1921,16 @@ gd::ni::read(gd::Context &&ctx,
   if (!!contextBlob)
     return readblob(std::move(ctx), *contextBlob, fullpath);
 
+  if (ctx.reads_) {
+    auto path = fullpath.relative_path().lexically_normal().string();
+    if (!ctx.reads_->contains(path)) {
+      if (!ctx.tip_.root_) // Nothing was committed yet
+        ctx.reads_->emplace(std::move(path), std::nullopt);
+      else if (auto id = idAt(ctx.tip_.root_, path); !!id)
+        ctx.reads_->emplace(std::move(path), *id);
+    }
+  }
+
   auto blob = getBlobFromTreeByPath(ctx.tip_.root_, fullpath);
   if (!blob)
     return gd_unexpected(std::move(blob));
@@ -710,21 +1941,1482 @@ gd::ni::read(gd::Context &&ctx,
 Result<gd::ReadContext>
 gd::ni::readblob(gd::Context &&ctx, git_blob *blob,
                  const std::filesystem::path &fullpath) noexcept {
+  if (git_blob_is_binary(blob)) // Filters don't apply, and content may hold NULs
+    return ReadContext(std::move(ctx),
+                       std::string(static_cast<const char *>(git_blob_rawcontent(blob)),
+                                   git_blob_rawsize(blob)));
+
   git_blob_filter_options opts = GIT_BLOB_FILTER_OPTIONS_INIT;
-  git_buf buffer = GIT_BUF_INIT_CONST("", 0);
+  git_buf buffer = GIT_BUF_INIT;
   if (git_blob_filter(&buffer, blob, fullpath.c_str(), &opts) != 0)
     return gd_unexpected();
 
-  std::string content(buffer.ptr, buffer.size);
+  std::string content(buffer.ptr ? buffer.ptr : "", buffer.size);
 
   git_buf_dispose(&buffer);
-  git_buf_free(&buffer);
 
   return ReadContext(std::move(ctx), std::move(content));
 }
 
-/// @brief Gets thread content, support for thread_local context call chaining
-/// @return The thread_local context
-Result<gd::Context> gd::shorthand::getThreadContext() noexcept {
-  return sGit.threadContext();
+namespace {
+/// @brief Resolves a revision to a commit id
+/// @param ctx The context, its tip is the starting point of point in time resolution
+/// @param rev A revision string, a commit id or a point in time
+/// @return On success the commit id, otherwise an Error
+Result<git_oid> resolveRevision(const gd::Context &ctx, const gd::Revision &rev) noexcept {
+  if (auto commitId = std::get_if<git_oid>(&rev))
+    return *commitId;
+
+  if (auto spec = std::get_if<std::string>(&rev)) {
+    auto commit = getCommitByRef(*ctx.repo_, *spec);
+    if (!commit)
+      return gd_unexpected(std::move(commit));
+    return *git_commit_id(*commit);
+  }
+
+  if (!ctx.getCommitId())
+    return gd_unexpected(gd::ErrorType::InitialContext, "No commits to search in time");
+
+  auto time = std::get<std::chrono::system_clock::time_point>(rev);
+  return getCommitByTime(*ctx.repo_, ctx.getCommitId(),
+                         std::chrono::system_clock::to_time_t(time));
+}
+
+/// @brief Retrieves the root tree of a commit, through the commit to root tree cache
+Result<gd::tree_t> rootTreeOf(git_repository *repo, const git_oid &commitId) noexcept {
+  if (auto treeId = sRootTrees.find(commitId))
+    return getTree(repo, &*treeId);
+
+  auto commit = getCommitById(repo, &commitId);
+  if (!commit)
+    return gd_unexpected(std::move(commit));
+
+  sRootTrees.insert(commitId, *git_commit_tree_id(*commit));
+  return getTreeOfCommit(repo, *commit);
+}
+} // namespace
+
+/// @brief Reads a blob by its id, regardless of any path or commit
+/// @param ctx The context used to access the repository
+/// @param blobId The blob's `git_oid`
+/// @return On success a ReadContext with the blob's raw content, otherwise an Error
+Result<gd::ReadContext>
+gd::ni::readById(gd::Context &&ctx, const git_oid &blobId) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  auto blob = getBlobById(*ctx.repo_, &blobId);
+  if (!blob)
+    return gd_unexpected(std::move(blob));
+
+  std::string content(static_cast<const char *>(git_blob_rawcontent(*blob)),
+                      git_blob_rawsize(*blob));
+  return ReadContext(std::move(ctx), std::move(content));
+}
+
+/// @brief Reads a file at a given revision, without moving the context's tip
+/// @param ctx The context used to access the repository
+/// @param fullpath The fullpath of the blob
+/// @param rev The revision to read at
+/// @return On success a ReadContext with the content, otherwise an Error
+Result<gd::ReadContext>
+gd::ni::readAt(gd::Context &&ctx, const std::filesystem::path &fullpath,
+               const gd::Revision &rev) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  auto commitId = resolveRevision(ctx, rev);
+  if (!commitId)
+    return gd_unexpected(std::move(commitId));
+
+  auto root = rootTreeOf(*ctx.repo_, *commitId);
+  if (!root)
+    return gd_unexpected(std::move(root));
+
+  auto blob = getBlobFromTreeByPath(*root, fullpath);
+  if (!blob)
+    return gd_unexpected(std::move(blob));
+
+  sLogger->debug("Read '{}' at {}", fullpath, *commitId);
+  return readblob(std::move(ctx), *blob, fullpath);
+}
+
+/// @brief Reads a byte range of a file, the file is found through `stat` (uncommitted updates first)
+/// @param ctx The context used to access the repository
+/// @param fullpath The fullpath of the blob
+/// @param offset The first byte to read
+/// @param length Maximum number of bytes to read
+/// @return On success a ReadContext with the bytes in range, otherwise an Error
+Result<gd::ReadContext>
+gd::ni::readRange(gd::Context &&ctx, const std::filesystem::path &fullpath,
+                  size_t offset, size_t length) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  auto entry = stat(ctx, fullpath);
+  if (!entry)
+    return gd_unexpected(std::move(entry));
+
+  if (entry->type_ != GIT_OBJECT_BLOB)
+    return gd_unexpected(gd::ErrorType::BadFile, fullpath.string() + " is not a file(blob)");
+
+  auto odb = getOdb(*ctx.repo_);
+  if (!odb)
+    return gd_unexpected(std::move(odb));
+
+  auto content = getBlobRange(*odb, &entry->oid_, offset, length);
+  if (!content)
+    return gd_unexpected(std::move(content));
+
+  return ReadContext(std::move(ctx), std::move(*content));
+}
+
+namespace {
+/// @brief Directories are keyed relative to the root and without a trailing separator
+std::filesystem::path normalDir(const std::filesystem::path &dir) noexcept {
+  auto normal = dir.relative_path().lexically_normal();
+  if (!normal.empty() && !normal.has_filename())
+    normal = normal.parent_path();
+  return normal == "." ? std::filesystem::path{} : normal;
+}
+
+/// @brief Converts a committed tree entry into a listing entry
+Result<gd::Entry> toEntry(git_odb *odb, const git_tree_entry *entry) noexcept {
+  if (git_tree_entry_type(entry) == GIT_OBJECT_COMMIT) // Submodules aren't in the odb
+    return gd::Entry{git_tree_entry_name(entry), GIT_OBJECT_COMMIT,
+                     *git_tree_entry_id(entry), GIT_FILEMODE_COMMIT, 0};
+
+  auto header = getObjectHeader(odb, git_tree_entry_id(entry));
+  if (!header)
+    return gd_unexpected(std::move(header));
+
+  return gd::Entry{git_tree_entry_name(entry), git_tree_entry_type(entry),
+                   *git_tree_entry_id(entry), git_tree_entry_filemode(entry),
+                   header->first};
+}
+
+/// @brief Converts an uncommitted update into a listing entry
+Result<gd::Entry> toEntry(git_odb *odb, const gd::ObjectUpdate &update) noexcept {
+  auto header = getObjectHeader(odb, update.oid());
+  if (!header)
+    return gd_unexpected(std::move(header));
+
+  return gd::Entry{update.name(), header->second, *update.oid(), update.mod(),
+                   header->first};
+}
+
+/// @brief Loads a directory's tree, given its path and its tree id when known (nullptr to resolve the path)
+using TreeLoader = std::function<Result<gd::tree_t>(const std::filesystem::path &, const git_oid *)>;
+
+/// @brief The lazy listing, all arguments are owned by the coroutine frame
+/// @param load Loads the listed directory instead of resolving it from rootId (i.e. a snapshot's cache)
+gd::Generator<Result<gd::Entry>>
+lazyEntries(git_repository *repo, std::optional<git_oid> rootId,
+            std::filesystem::path dir,
+            std::map<std::string, gd::ObjectUpdate> pending,
+            std::set<std::string> pendingDirs, TreeLoader load = {}) noexcept {
+  if (!repo) {
+    co_yield gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+    co_return;
+  }
+
+  auto odb = getOdb(repo);
+  if (!odb) {
+    co_yield gd_unexpected(std::move(odb));
+    co_return;
+  }
+
+  gd::tree_t tree;
+  if (load) {
+    auto loaded = load(dir, nullptr);
+    if (!loaded) {
+      co_yield gd_unexpected(std::move(loaded));
+      co_return;
+    }
+    tree = std::move(*loaded);
+  } else if (rootId) {
+    auto root = getTree(repo, &*rootId);
+    if (!root) {
+      co_yield gd_unexpected(std::move(root));
+      co_return;
+    }
+
+    auto subtree = dir.empty() ? std::move(root) : getTreeRelativeToRoot(repo, *root, dir);
+    if (!subtree) {
+      co_yield gd_unexpected(std::move(subtree));
+      co_return;
+    }
+    tree = std::move(*subtree);
+  }
+
+  if (!tree && pending.empty() && pendingDirs.empty()) {
+    co_yield gd_unexpected(gd::ErrorType::NotFound, "'" + dir.string() + "' not found");
+    co_return;
+  }
+
+  for (size_t i = 0, count = tree ? git_tree_entrycount(tree) : 0; i < count; ++i) {
+    auto entry = git_tree_entry_byindex(tree, i);
+    std::string name = git_tree_entry_name(entry);
+
+    // A removed directory is still implied by updates made below it since
+    if (auto update = pending.extract(name); !update.empty()) {
+      if (!update.mapped().isDelete()) {
+        pendingDirs.erase(name);
+        co_yield toEntry(*odb, update.mapped());
+      }
+    } else {
+      pendingDirs.erase(name);
+      co_yield toEntry(*odb, entry);
+    }
+  }
+
+  for (const auto &[name, update] : pending) {
+    if (!update.isDelete()) {
+      pendingDirs.erase(name);
+      co_yield toEntry(*odb, update);
+    }
+  }
+
+  git_oid unwritten;
+  std::memset(&unwritten, 0, sizeof(git_oid));
+  for (const auto &name : pendingDirs) {
+    Result<gd::Entry> implied = gd::Entry{name, GIT_OBJECT_TREE, unwritten, GIT_FILEMODE_TREE, 0};
+    co_yield std::move(implied);
+  }
+}
+} // namespace
+
+gd::Generator<Result<gd::Entry>>
+gd::entries(const gd::Context &ctx, const std::filesystem::path &dir) noexcept {
+  auto normal = normalDir(dir);
+  std::optional<git_oid> rootId;
+  if (ctx.tip_.root_ && !ctx.updates_.removed(normal))
+    rootId = *git_tree_id(ctx.tip_.root_);
+
+  return lazyEntries(ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr,
+                     rootId, normal, ctx.updates_.pending(normal),
+                     ctx.updates_.pendingDirs(normal));
+}
+
+Result<gd::Entry>
+gd::stat(const gd::Context &ctx, const std::filesystem::path &fullpath) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  auto odb = getOdb(*ctx.repo_);
+  if (!odb)
+    return gd_unexpected(std::move(odb));
+
+  // Uncommitted updates take precedence, be it of the path, the removal of one of its directories or the
+  // replacement of one (i.e. moved), the rest of the path is then resolved within the replacing tree
+  auto normal = normalDir(fullpath);
+  const git_tree *root = ctx.tip_.root_;
+  auto within = normal;
+  gd::tree_t replaced;
+  for (auto path = normal; !path.empty(); path = path.parent_path()) {
+    auto update = ctx.updates_.find(path);
+    if (update && update->isDelete())
+      return gd_unexpected(gd::ErrorType::Deleted, normal.string() + " deleted in uncommitted context");
+    if (update && path == normal)
+      return toEntry(*odb, *update);
+    if (update && update->mod() == GIT_FILEMODE_TREE) {
+      auto tree = getTree(*ctx.repo_, update->oid());
+      if (!tree)
+        return gd_unexpected(std::move(tree));
+      replaced = std::move(*tree);
+      root = replaced;
+      within = normal.lexically_relative(path);
+      break;
+    }
+  }
+
+  if (normal.empty() && ctx.tip_.root_) {
+    auto header = getObjectHeader(*odb, git_tree_id(ctx.tip_.root_));
+    if (!header)
+      return gd_unexpected(std::move(header));
+    return gd::Entry{"", GIT_OBJECT_TREE, *git_tree_id(ctx.tip_.root_), GIT_FILEMODE_TREE, header->first};
+  }
+
+  git_tree_entry *found{nullptr};
+  int result = root ? git_tree_entry_bypath(&found, root, within.c_str()) : GIT_ENOTFOUND;
+  if (result == GIT_OK) {
+    gd::entry_t entry{found};
+    return toEntry(*odb, entry);
+  }
+  if (result != GIT_ENOTFOUND)
+    return gd_unexpected();
+
+  if (!normal.empty() && ctx.updates_.pendingDirs(normal.parent_path()).contains(normal.filename())) {
+    git_oid unwritten;
+    std::memset(&unwritten, 0, sizeof(git_oid));
+    return gd::Entry{normal.filename(), GIT_OBJECT_TREE, unwritten, GIT_FILEMODE_TREE, 0};
+  }
+  return gd_unexpected(gd::ErrorType::NotFound, "'" + normal.string() + "' not found");
+}
+
+Result<bool>
+gd::exists(const gd::Context &ctx, const std::filesystem::path &fullpath) noexcept {
+  auto entry = stat(ctx, fullpath);
+  if (!!entry)
+    return true;
+
+  if (auto type = entry.error()._type; type == gd::ErrorType::NotFound || type == gd::ErrorType::Deleted)
+    return false;
+  return gd_unexpected(std::move(entry));
+}
+
+Result<std::string> gd::WalkItem::content() const noexcept {
+  if (isDir())
+    return gd_unexpected(gd::ErrorType::BadFile, path_.string() + " is a directory");
+
+  auto blob = getBlobById(repo_, &oid_);
+  if (!blob)
+    return gd_unexpected(std::move(blob));
+
+  return std::string(static_cast<const char *>(git_blob_rawcontent(*blob)),
+                     git_blob_rawsize(*blob));
+}
+
+namespace {
+/// @brief The lazy walk, depth first using an explicit stack of open directories
+/// @param load Loads the directories instead of getting them from the repository (i.e. a snapshot's cache)
+gd::Generator<Result<gd::WalkItem>>
+lazyWalk(git_repository *repo, std::optional<git_oid> rootId,
+         std::filesystem::path prefix, gd::WalkOptions opts, TreeLoader load = {}) noexcept {
+  if (!repo) {
+    co_yield gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+    co_return;
+  }
+
+  if (!rootId) { // Nothing was committed yet
+    if (!prefix.empty())
+      co_yield gd_unexpected(gd::ErrorType::NotFound, "'" + prefix.string() + "' not found");
+    co_return;
+  }
+
+  if (!load)
+    load = [repo, rootId](const std::filesystem::path &dir, const git_oid *id) -> Result<gd::tree_t> {
+      if (id)
+        return getTree(repo, id);
+      auto root = getTree(repo, &*rootId);
+      if (!root || dir.empty())
+        return root;
+      return getTreeRelativeToRoot(repo, *root, dir);
+    };
+
+  auto tree = load(prefix, nullptr);
+  if (!tree) {
+    co_yield gd_unexpected(std::move(tree));
+    co_return;
+  }
+  if (!*tree) {
+    co_yield gd_unexpected(gd::ErrorType::NotFound, "'" + prefix.string() + "' not found");
+    co_return;
+  }
+
+  struct OpenDir {
+    gd::tree_t tree_;
+    size_t next_;
+    std::filesystem::path dir_;
+    std::optional<gd::WalkItem> self_; /* Deferred directory item for post order */
+  };
+
+  std::vector<OpenDir> stack;
+  stack.push_back({std::move(*tree), 0, prefix, std::nullopt});
+
+  while (!stack.empty()) {
+    auto &top = stack.back();
+    if (top.next_ == git_tree_entrycount(top.tree_)) {
+      auto self = std::move(top.self_);
+      stack.pop_back();
+      if (self)
+        co_yield std::move(*self);
+      continue;
+    }
+
+    auto entry = git_tree_entry_byindex(top.tree_, top.next_++);
+    gd::WalkItem item{top.dir_ / git_tree_entry_name(entry), *git_tree_entry_id(entry),
+                      git_tree_entry_filemode(entry), repo};
+
+    bool descend = git_tree_entry_type(entry) == GIT_OBJECT_TREE && stack.size() < opts.maxDepth_;
+    if (!descend || opts.order_ == gd::WalkOrder::PreOrder)
+      co_yield item;
+
+    if (descend) {
+      auto subtree = load(item.path_, &item.oid_);
+      if (!subtree) {
+        co_yield gd_unexpected(std::move(subtree));
+        co_return;
+      }
+
+      auto dir = item.path_;
+      std::optional<gd::WalkItem> self;
+      if (opts.order_ == gd::WalkOrder::PostOrder)
+        self = std::move(item);
+      stack.push_back({std::move(*subtree), 0, std::move(dir), std::move(self)});
+    }
+  }
+}
+} // namespace
+
+gd::Generator<Result<gd::WalkItem>>
+gd::walk(const gd::Context &ctx, const std::filesystem::path &prefix,
+         gd::WalkOptions opts) noexcept {
+  std::optional<git_oid> rootId;
+  if (ctx.tip_.root_)
+    rootId = *git_tree_id(ctx.tip_.root_);
+
+  return lazyWalk(ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr,
+                  rootId, normalDir(prefix), opts);
+}
+
+std::string gd::ScanCursor::token() const noexcept {
+  char hex[GIT_OID_HEXSZ + 1];
+  git_oid_tostr(hex, sizeof(hex), &root_);
+  return std::string(hex) + ":" + after_;
+}
+
+Result<gd::ScanCursor> gd::ScanCursor::fromToken(const std::string &token) noexcept {
+  if (token.size() <= GIT_OID_HEXSZ || token[GIT_OID_HEXSZ] != ':')
+    return gd_unexpected(gd::ErrorType::Application, "Malformed scan cursor '" + token + "'");
+
+  ScanCursor cursor{.root_ = {}, .after_ = token.substr(GIT_OID_HEXSZ + 1)};
+  if (git_oid_fromstrn(&cursor.root_, token.data(), GIT_OID_HEXSZ) != 0)
+    return gd_unexpected();
+
+  return cursor;
+}
+
+namespace {
+/// @brief Scans the files of a root tree from a key, depth first.
+///        git orders a directory's entries as if directory names ended with '/', thus a depth first walk
+///        visits full paths in lexicographic order, and a directory holds exactly the keys starting with
+///        its path and a '/'. Directories before `from` are skipped by a binary search, per level.
+/// @param from The lower bound key
+/// @param inclusive Whether `from` itself is in range, false when resuming after a returned key
+Result<gd::ScanPage> scanTree(git_repository *repo, const git_oid &rootId, const std::string &from,
+                              bool inclusive, const std::string &end, size_t limit) noexcept {
+  auto root = getTree(repo, &rootId);
+  if (!root)
+    return gd_unexpected(std::move(root));
+
+  auto before = [&](const std::string &key, bool isDir) {
+    if (isDir)
+      return key < from && !from.starts_with(key);
+    return inclusive ? key < from : key <= from;
+  };
+
+  auto lowerBound = [&](const git_tree *tree, const std::string &prefix) {
+    size_t low = 0, high = git_tree_entrycount(tree);
+    while (low < high) {
+      auto mid = low + (high - low) / 2;
+      auto entry = git_tree_entry_byindex(tree, mid);
+      bool isDir = git_tree_entry_type(entry) == GIT_OBJECT_TREE;
+      if (before(prefix + git_tree_entry_name(entry) + (isDir ? "/" : ""), isDir))
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    return low;
+  };
+
+  struct OpenDir {
+    gd::tree_t tree_;
+    size_t next_;
+    std::string prefix_;
+  };
+
+  std::vector<OpenDir> stack;
+  auto first = lowerBound(*root, "");
+  stack.push_back({std::move(*root), first, ""});
+
+  gd::ScanPage page;
+  limit = std::max<size_t>(limit, 1);
+  while (!stack.empty()) {
+    auto &top = stack.back();
+    if (top.next_ == git_tree_entrycount(top.tree_)) {
+      stack.pop_back();
+      continue;
+    }
+
+    auto entry = git_tree_entry_byindex(top.tree_, top.next_++);
+    bool isDir = git_tree_entry_type(entry) == GIT_OBJECT_TREE;
+    auto key = top.prefix_ + git_tree_entry_name(entry) + (isDir ? "/" : "");
+    if (!end.empty() && key >= end) // Every later key is greater
+      break;
+
+    if (isDir) {
+      auto subtree = getTree(repo, git_tree_entry_id(entry));
+      if (!subtree)
+        return gd_unexpected(std::move(subtree));
+
+      auto next = lowerBound(*subtree, key);
+      stack.push_back({std::move(*subtree), next, std::move(key)});
+      continue;
+    }
+
+    if (page.items_.size() == limit) { // A file beyond the page, resume after the page's last
+      page.next_ = gd::ScanCursor{rootId, page.items_.back().path_.string()};
+      break;
+    }
+    page.items_.push_back({std::move(key), *git_tree_entry_id(entry), git_tree_entry_filemode(entry), repo});
+  }
+
+  return page;
+}
+} // namespace
+
+Result<gd::ScanPage> gd::scan(const gd::Context &ctx, const std::string &start,
+                              const std::string &end, size_t limit) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  if (!ctx.tip_.root_) // Nothing was committed yet
+    return ScanPage{};
+
+  return scanTree(*ctx.repo_, *git_tree_id(ctx.tip_.root_), start, true, end, limit);
+}
+
+Result<gd::ScanPage> gd::scan(const gd::Context &ctx, const gd::ScanCursor &from,
+                              const std::string &end, size_t limit) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  return scanTree(*ctx.repo_, from.root_, from.after_, false, end, limit);
+}
+
+namespace {
+/// @brief Matches full paths, and tells directories which can't hold a match apart
+class PathMatcher {
+public:
+  virtual ~PathMatcher() = default;
+
+  /// @brief Tests a file's full path
+  /// @return On success whether the path matches, otherwise an Error (i.e. a regex too complex for the path)
+  virtual Result<bool> matches(const std::string &fullpath) const noexcept = 0;
+
+  /// @brief Tests whether a file below a directory may match, false prunes the directory
+  virtual bool mayContain(const std::string &dir) const noexcept = 0;
+};
+
+/// @return The position after a glob's character class starting at `pos`, npos if unterminated
+size_t classEnd(std::string_view glob, size_t pos) noexcept {
+  size_t i = pos + 1;
+  if (i < glob.size() && (glob[i] == '!' || glob[i] == '^'))
+    ++i;
+  if (i < glob.size() && glob[i] == ']') // A leading ']' is a member
+    ++i;
+  while (i < glob.size() && glob[i] != ']')
+    ++i;
+  return i < glob.size() ? i + 1 : std::string_view::npos;
+}
+
+/// @brief Tests a character against a class's members (i.e. "a-z_" or "!0-9")
+bool inClass(std::string_view members, char c) noexcept {
+  bool negate = !members.empty() && (members[0] == '!' || members[0] == '^');
+  if (negate)
+    members.remove_prefix(1);
+
+  bool found = false;
+  for (size_t i = 0; i < members.size(); ++i) {
+    if (i + 2 < members.size() && members[i + 1] == '-') {
+      found |= members[i] <= c && c <= members[i + 2];
+      i += 2;
+    } else {
+      found |= members[i] == c;
+    }
+  }
+  return found != negate;
+}
+
+/// @brief Matches a name against a glob segment, backtracking to the last '*' only
+bool globMatch(std::string_view glob, std::string_view name) noexcept {
+  constexpr auto npos = std::string_view::npos;
+  size_t g = 0, n = 0, star = npos, starN = 0;
+  while (n < name.size()) {
+    if (g < glob.size() && glob[g] == '*') {
+      star = g++;
+      starN = n;
+      continue;
+    }
+
+    bool step = false;
+    size_t next = g + 1;
+    if (g < glob.size()) {
+      if (glob[g] == '?') {
+        step = true;
+      } else if (glob[g] == '[' && (next = classEnd(glob, g)) != npos) {
+        step = inClass(glob.substr(g + 1, next - g - 2), name[n]);
+      } else {
+        auto literal = glob[g] == '\\' && g + 1 < glob.size() ? g + 1 : g;
+        step = glob[literal] == name[n];
+        next = literal + 1;
+      }
+    }
+
+    if (step) {
+      g = next;
+      ++n;
+    } else if (star != npos) {
+      g = star + 1;
+      n = ++starN;
+    } else {
+      return false;
+    }
+  }
+
+  while (g < glob.size() && glob[g] == '*')
+    ++g;
+  return g == glob.size();
+}
+
+/// @brief A glob, run as a non deterministic automaton over the path's segments: a state is the number
+///        of pattern segments matched. A directory is pruned once no state is left short of the last segment.
+class GlobMatcher : public PathMatcher {
+  std::vector<std::string> segments_;
+
+  using States = std::vector<bool>;
+
+  /// @brief Adds the states reached by '**' matching no segment
+  void close(States &states) const noexcept {
+    for (size_t i = 0; i < segments_.size(); ++i)
+      if (states[i] && segments_[i] == "**")
+        states[i + 1] = true;
+  }
+
+  States run(const std::string &path) const noexcept {
+    States states(segments_.size() + 1, false);
+    states[0] = true;
+    close(states);
+
+    for (const auto &segment : std::filesystem::path(path)) {
+      States next(states.size(), false);
+      for (size_t i = 0; i < segments_.size(); ++i) {
+        if (!states[i])
+          continue;
+        if (segments_[i] == "**")
+          next[i] = true;
+        else if (globMatch(segments_[i], segment.native()))
+          next[i + 1] = true;
+      }
+      close(next);
+      states = std::move(next);
+    }
+    return states;
+  }
+
+public:
+  explicit GlobMatcher(const std::string &pattern) noexcept {
+    for (const auto &segment : std::filesystem::path(pattern))
+      if (segment != "/" && !segment.empty())
+        segments_.push_back(segment);
+  }
+
+  Result<bool> matches(const std::string &fullpath) const noexcept override {
+    return run(fullpath).back();
+  }
+
+  bool mayContain(const std::string &dir) const noexcept override {
+    auto states = run(dir);
+    return std::ranges::any_of(states.begin(), std::prev(states.end()), std::identity{});
+  }
+};
+
+/// @brief A regular expression on the full path, pruned by the literal text every match starts with
+class RegexMatcher : public PathMatcher {
+  std::regex regex_;
+  std::string prefix_;
+
+  /// @brief The literal prefix of a regex (i.e. "docs/" of "docs/.*\.md"), empty when unsure
+  static std::string literalPrefix(const std::string &pattern) noexcept {
+    if (pattern.find('|') != std::string::npos) // Alternatives may start anywhere
+      return {};
+
+    std::string prefix;
+    for (size_t i = pattern.starts_with('^') ? 1 : 0; i < pattern.size();) {
+      char literal = pattern[i];
+      size_t length = 1;
+      if (literal == '\\') {
+        if (i + 1 == pattern.size() || !std::ispunct(static_cast<unsigned char>(pattern[i + 1])))
+          break; // A character class, i.e. "\d"
+        literal = pattern[i + 1];
+        length = 2;
+      } else if (std::strchr("^$.|?*+()[]{}", literal)) {
+        break;
+      }
+
+      if (i + length < pattern.size() && std::strchr("?*{", pattern[i + length]))
+        break; // An optional literal
+      prefix += literal;
+      i += length;
+    }
+    return prefix;
+  }
+
+public:
+  explicit RegexMatcher(const std::string &pattern)
+  : regex_(pattern, std::regex::ECMAScript | std::regex::optimize), prefix_(literalPrefix(pattern)) {}
+
+  Result<bool> matches(const std::string &fullpath) const noexcept override {
+    if (!fullpath.starts_with(prefix_))
+      return false;
+
+    try { // Backtracking may exhaust the matcher's complexity or stack limits
+      return std::regex_match(fullpath, regex_);
+    } catch (const std::regex_error &e) {
+      return gd_unexpected(gd::ErrorType::Application, "Matching '" + fullpath + "' failed: " + e.what());
+    }
+  }
+
+  bool mayContain(const std::string &dir) const noexcept override {
+    auto keys = dir.empty() ? dir : dir + "/"; // Keys below the directory start with it
+    return keys.starts_with(prefix_) || prefix_.starts_with(keys);
+  }
+};
+
+/// @brief The lazy find, depth first over the directories the matcher doesn't prune.
+///        A directory's tree is the committed one unless replaced by an update (i.e. moved), and its
+///        entries are merged with its uncommitted updates, as `lazyEntries` does.
+gd::Generator<Result<gd::WalkItem>>
+lazyFind(git_repository *repo, std::optional<git_oid> rootId, std::string pattern, gd::PatternKind kind,
+         std::map<std::filesystem::path, gd::ObjectUpdate> changes) noexcept {
+  if (!repo) {
+    co_yield gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+    co_return;
+  }
+
+  std::unique_ptr<PathMatcher> matcher;
+  std::string malformed;
+  try {
+    if (kind == gd::PatternKind::Regex)
+      matcher = std::make_unique<RegexMatcher>(pattern);
+    else
+      matcher = std::make_unique<GlobMatcher>(pattern);
+  } catch (const std::regex_error &e) {
+    malformed = e.what();
+  }
+  if (!matcher) {
+    co_yield gd_unexpected(gd::ErrorType::Application, "Malformed pattern '" + pattern + "': " + malformed);
+    co_return;
+  }
+
+  std::map<std::filesystem::path, std::map<std::string, gd::ObjectUpdate>> pending;
+  std::map<std::filesystem::path, std::set<std::string>> pendingDirs;
+  for (const auto &[path, update] : changes) {
+    pending[path.parent_path()].insert_or_assign(update.name(), update);
+    for (auto dir = path.parent_path(); !dir.empty(); dir = dir.parent_path())
+      pendingDirs[dir.parent_path()].insert(dir.filename());
+  }
+
+  struct Dir {
+    std::filesystem::path path_;
+    std::optional<git_oid> tree_; /* Empty for a directory implied by updates only */
+  };
+
+  std::vector<Dir> stack;
+  if (rootId || !changes.empty())
+    stack.push_back({{}, rootId});
+
+  while (!stack.empty()) {
+    auto dir = std::move(stack.back());
+    stack.pop_back();
+
+    gd::tree_t tree;
+    if (dir.tree_) {
+      auto res = getTree(repo, &*dir.tree_);
+      if (!res) {
+        co_yield gd_unexpected(std::move(res));
+        co_return;
+      }
+      tree = std::move(*res);
+    }
+
+    auto updates = std::move(pending[dir.path_]);
+    auto implied = std::move(pendingDirs[dir.path_]);
+
+    // Committed entries first (unless removed or replaced), then the newly introduced ones
+    std::vector<std::tuple<std::string, git_oid, git_filemode_t>> listed;
+    for (size_t i = 0, count = tree ? git_tree_entrycount(tree) : 0; i < count; ++i) {
+      auto entry = git_tree_entry_byindex(tree, i);
+      std::string name = git_tree_entry_name(entry);
+
+      // A removed directory is still implied by updates made below it since, without its committed tree
+      if (auto update = updates.extract(name); !update.empty()) {
+        if (!update.mapped().isDelete()) {
+          implied.erase(name);
+          listed.emplace_back(std::move(name), *update.mapped().oid(), update.mapped().mod());
+        }
+      } else {
+        implied.erase(name);
+        listed.emplace_back(std::move(name), *git_tree_entry_id(entry), git_tree_entry_filemode(entry));
+      }
+    }
+    for (const auto &[name, update] : updates) {
+      if (!update.isDelete()) {
+        implied.erase(name);
+        listed.emplace_back(name, *update.oid(), update.mod());
+      }
+    }
+
+    std::vector<Dir> subdirs;
+    for (auto &[name, oid, mode] : listed) {
+      auto path = dir.path_ / name;
+      if (mode == GIT_FILEMODE_TREE) {
+        if (matcher->mayContain(path.string()))
+          subdirs.push_back({std::move(path), oid});
+      } else if (mode != GIT_FILEMODE_COMMIT) {
+        auto matched = matcher->matches(path.string());
+        if (!matched) {
+          co_yield gd_unexpected(std::move(matched));
+          co_return;
+        }
+        if (*matched) {
+          gd::WalkItem item{std::move(path), oid, mode, repo};
+          co_yield item;
+        }
+      }
+    }
+    for (const auto &name : implied)
+      if (auto path = dir.path_ / name; matcher->mayContain(path.string()))
+        subdirs.push_back({std::move(path), std::nullopt});
+
+    std::move(subdirs.rbegin(), subdirs.rend(), std::back_inserter(stack));
+  }
+}
+} // namespace
+
+gd::Generator<Result<gd::WalkItem>>
+gd::find(const gd::Context &ctx, const std::string &pattern, gd::PatternKind kind) noexcept {
+  std::optional<git_oid> rootId;
+  if (ctx.tip_.root_)
+    rootId = *git_tree_id(ctx.tip_.root_);
+
+  return lazyFind(ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr,
+                  rootId, pattern, kind, ctx.updates_.changes());
+}
+
+namespace {
+/// @brief Tests whether a file changed between a commit's tree and one of its parent's, by walking down
+///        the file's directory chain in both, and stopping at the first level with equal oids.
+/// @param repo The repository
+/// @param tree The commit's root tree
+/// @param parent The parent's root tree, nullptr for a root commit
+/// @param fullpath The file's path components
+/// @param blobId [out] The file's blob in `tree`, set only when the file is present
+/// @return True if the file exists in `tree` and differs from `parent`, otherwise False, or an Error
+Result<bool> changedAlong(git_repository *repo, const git_tree *tree, const git_tree *parent,
+                          const std::filesystem::path &fullpath, git_oid &blobId) noexcept {
+  gd::tree_t ownedTree, ownedParent;
+  for (auto itr = fullpath.begin(); itr != fullpath.end(); ++itr) {
+    if (parent && git_oid_equal(git_tree_id(tree), git_tree_id(parent)))
+      return false;
+
+    auto entry = git_tree_entry_byname(tree, itr->c_str());
+    if (!entry)
+      return false; // Not (or no longer) in this commit
+
+    auto parentEntry = parent ? git_tree_entry_byname(parent, itr->c_str()) : nullptr;
+    if (parentEntry && git_oid_equal(git_tree_entry_id(entry), git_tree_entry_id(parentEntry)))
+      return false;
+
+    if (std::next(itr) == fullpath.end()) {
+      if (git_tree_entry_type(entry) != GIT_OBJECT_BLOB)
+        return false;
+
+      blobId = *git_tree_entry_id(entry);
+      return true;
+    }
+
+    if (git_tree_entry_type(entry) != GIT_OBJECT_TREE)
+      return false;
+
+    auto subtree = getTree(repo, git_tree_entry_id(entry));
+    if (!subtree)
+      return gd_unexpected(std::move(subtree));
+
+    gd::tree_t subParent;
+    if (parentEntry && git_tree_entry_type(parentEntry) == GIT_OBJECT_TREE) {
+      auto found = getTree(repo, git_tree_entry_id(parentEntry));
+      if (!found)
+        return gd_unexpected(std::move(found));
+      subParent = std::move(*found);
+    }
+
+    ownedTree = std::move(*subtree);
+    ownedParent = std::move(subParent);
+    tree = ownedTree;
+    parent = ownedParent;
+  }
+  return false;
+}
+
+/// @brief Tests whether a commit introduces a version of a file, that is the file differs from all
+///        of the commit's parents (like git log's default history simplification)
+Result<bool> changedFromParents(git_repository *repo, const git_commit *commit, const git_tree *tree,
+                                const std::filesystem::path &fullpath, git_oid &blobId) noexcept {
+  auto count = git_commit_parentcount(commit);
+  if (count == 0)
+    return changedAlong(repo, tree, nullptr, fullpath, blobId);
+
+  for (unsigned int i = 0; i < count; ++i) {
+    auto parent = getCommitById(repo, git_commit_parent_id(commit, i));
+    if (!parent)
+      return gd_unexpected(std::move(parent));
+
+    auto parentTree = getTreeOfCommit(repo, *parent);
+    if (!parentTree)
+      return gd_unexpected(std::move(parentTree));
+
+    auto differs = changedAlong(repo, tree, *parentTree, fullpath, blobId);
+    if (!differs || !*differs)
+      return differs;
+  }
+  return true;
+}
+
+/// @brief The lazy history search, commits are walked in time order from `tipId`
+gd::Generator<Result<gd::Version>>
+lazyHistory(git_repository *repo, std::optional<git_oid> tipId, std::filesystem::path fullpath,
+            gd::HistoryOptions opts, std::optional<gd::PathFilters> filters) noexcept {
+  if (!repo) {
+    co_yield gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+    co_return;
+  }
+
+  if (!tipId || fullpath.empty() || opts.limit_ == 0)
+    co_return;
+
+  git_revwalk *walker{nullptr};
+  if (git_revwalk_new(&walker, repo) != 0) {
+    co_yield gd_unexpected();
+    co_return;
+  }
+
+  gd::revwalk_t walk{walker};
+  if (git_revwalk_sorting(walk, GIT_SORT_TIME) != 0 || git_revwalk_push(walk, &*tipId) != 0) {
+    co_yield gd_unexpected();
+    co_return;
+  }
+
+  size_t found = 0;
+  git_oid commitId;
+  while (git_revwalk_next(&commitId, walk) == 0) {
+    if (filters && !filters->mayHaveChanged(commitId, fullpath))
+      continue;
+
+    auto commit = getCommitById(repo, &commitId);
+    if (!commit) {
+      co_yield gd_unexpected(std::move(commit));
+      co_return;
+    }
+
+    auto time = std::chrono::system_clock::from_time_t(git_commit_time(*commit));
+    if (opts.since_ && time < *opts.since_)
+      co_return; // Time ordered, all remaining commits are older
+    if (opts.until_ && time > *opts.until_)
+      continue;
+
+    auto tree = getTreeOfCommit(repo, *commit);
+    if (!tree) {
+      co_yield gd_unexpected(std::move(tree));
+      co_return;
+    }
+
+    git_oid blobId;
+    auto changed = changedFromParents(repo, *commit, *tree, fullpath, blobId);
+    if (!changed) {
+      co_yield gd_unexpected(std::move(changed));
+      co_return;
+    }
+
+    if (!*changed)
+      continue;
+
+    auto author = git_commit_author(*commit);
+    Result<gd::Version> version = gd::Version{commitId, blobId, author->name, author->email, time};
+    co_yield std::move(version);
+
+    if (++found == opts.limit_)
+      co_return;
+  }
+}
+} // namespace
+
+gd::Generator<Result<gd::Version>>
+gd::history(const gd::Context &ctx, const std::filesystem::path &fullpath,
+            gd::HistoryOptions opts) noexcept {
+  std::optional<git_oid> tipId;
+  if (ctx.getCommitId())
+    tipId = *ctx.getCommitId();
+
+  std::optional<gd::PathFilters> filters;
+  if (ctx.repo_)
+    if (auto loaded = gd::internal::currentPathFilters(*ctx.repo_); !!loaded)
+      filters = std::move(*loaded);
+
+  return lazyHistory(ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr,
+                     tipId, fullpath.relative_path().lexically_normal(), opts, std::move(filters));
+}
+
+namespace {
+/// @brief Tests whether a commit changed a path compared to all of its parents
+Result<bool> changedByCommit(git_repository *repo, git_commit *commit, const std::string &path) noexcept {
+  auto tree = getTreeOfCommit(repo, commit);
+  if (!tree)
+    return gd_unexpected(std::move(tree));
+
+  auto id = idAt(*tree, path);
+  if (!id)
+    return gd_unexpected(std::move(id));
+
+  auto count = git_commit_parentcount(commit);
+  if (count == 0)
+    return id->has_value();
+
+  for (unsigned int i = 0; i < count; ++i) {
+    auto parent = getCommitById(repo, git_commit_parent_id(commit, i));
+    if (!parent)
+      return gd_unexpected(std::move(parent));
+
+    auto parentTree = getTreeOfCommit(repo, *parent);
+    if (!parentTree)
+      return gd_unexpected(std::move(parentTree));
+
+    auto parentId = idAt(*parentTree, path);
+    if (!parentId)
+      return gd_unexpected(std::move(parentId));
+
+    if (id->has_value() == parentId->has_value() && (!*id || git_oid_equal(&**id, &**parentId)))
+      return false;
+  }
+  return true;
+}
+} // namespace
+
+Result<bool> gd::changedSince(const gd::Context &ctx, const gd::Revision &since,
+                              const std::filesystem::path &fullpath) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+  if (!ctx.getCommitId())
+    return false;
+
+  auto sinceId = resolveRevision(ctx, since);
+  if (!sinceId)
+    return gd_unexpected(std::move(sinceId));
+
+  auto path = fullpath.relative_path().lexically_normal().generic_string();
+  if (path.ends_with('/'))
+    path.pop_back();
+
+  std::optional<gd::PathFilters> filters;
+  if (auto loaded = gd::internal::currentPathFilters(*ctx.repo_); !!loaded)
+    filters = std::move(*loaded);
+
+  git_revwalk *walker{nullptr};
+  if (git_revwalk_new(&walker, *ctx.repo_) != 0)
+    return gd_unexpected();
+
+  gd::revwalk_t walk{walker};
+  if (git_revwalk_push(walk, ctx.getCommitId()) != 0 || git_revwalk_hide(walk, &*sinceId) != 0)
+    return gd_unexpected();
+
+  git_oid commitId;
+  while (git_revwalk_next(&commitId, walk) == 0) {
+    if (filters && !filters->mayHaveChanged(commitId, path))
+      continue;
+
+    auto commit = getCommitById(*ctx.repo_, &commitId);
+    if (!commit)
+      return gd_unexpected(std::move(commit));
+
+    auto changed = changedByCommit(*ctx.repo_, *commit, path);
+    if (!changed || *changed)
+      return changed;
+  }
+  return false;
+}
+
+namespace {
+/// @brief The oid of a prefix's tree at a revision
+/// @return On success the tree's oid, or nullopt when the prefix doesn't exist at the revision, otherwise an Error
+Result<std::optional<git_oid>> treeAt(const gd::Context &ctx, const gd::Revision &rev,
+                                      const std::filesystem::path &prefix) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  auto commitId = resolveRevision(ctx, rev);
+  if (!commitId)
+    return gd_unexpected(std::move(commitId));
+
+  auto root = rootTreeOf(*ctx.repo_, *commitId);
+  if (!root)
+    return gd_unexpected(std::move(root));
+
+  if (prefix.empty())
+    return *git_tree_id(*root);
+
+  auto subtree = getTreeRelativeToRoot(*ctx.repo_, *root, prefix);
+  if (!subtree)
+    return gd_unexpected(std::move(subtree));
+
+  if (!*subtree)
+    return std::nullopt;
+  return *git_tree_id(*subtree);
+}
+
+/// @brief The lazy comparison, depth first over pairs of trees with different oids
+gd::Generator<Result<gd::Change>>
+lazyDiff(git_repository *repo, Result<std::optional<git_oid>> fromId,
+         Result<std::optional<git_oid>> toId, std::filesystem::path prefix) noexcept {
+  if (!fromId) {
+    co_yield gd_unexpected(std::move(fromId));
+    co_return;
+  }
+  if (!toId) {
+    co_yield gd_unexpected(std::move(toId));
+    co_return;
+  }
+
+  auto load = [repo](const git_oid *id) -> Result<gd::tree_t> {
+    if (!id)
+      return gd::tree_t{};
+    return getTree(repo, id);
+  };
+
+  struct TreePair {
+    gd::tree_t old_, new_;
+    size_t oldNext_, newNext_;
+    std::filesystem::path dir_;
+  };
+
+  std::vector<TreePair> stack;
+  auto push = [&](const git_oid *oldId, const git_oid *newId,
+                  std::filesystem::path dir) -> Result<void> {
+    auto oldTree = load(oldId);
+    if (!oldTree)
+      return gd_unexpected(std::move(oldTree));
+
+    auto newTree = load(newId);
+    if (!newTree)
+      return gd_unexpected(std::move(newTree));
+
+    stack.push_back({std::move(*oldTree), std::move(*newTree), 0, 0, std::move(dir)});
+    return Result<void>();
+  };
+
+  auto &from = *fromId, &to = *toId;
+  if (from.has_value() != to.has_value() || (from && !git_oid_equal(&*from, &*to))) {
+    if (auto pushed = push(from ? &*from : nullptr, to ? &*to : nullptr, prefix); !pushed) {
+      co_yield gd_unexpected(std::move(pushed));
+      co_return;
+    }
+  }
+
+  std::vector<gd::Change> added, deleted; // Held back for rename detection
+  git_oid zero;
+  std::memset(&zero, 0, sizeof(git_oid));
+
+  while (!stack.empty()) {
+    auto &top = stack.back();
+    size_t oldCount = top.old_ ? git_tree_entrycount(top.old_) : 0;
+    size_t newCount = top.new_ ? git_tree_entrycount(top.new_) : 0;
+    if (top.oldNext_ == oldCount && top.newNext_ == newCount) {
+      stack.pop_back();
+      continue;
+    }
+
+    auto oldEntry = top.oldNext_ < oldCount ? git_tree_entry_byindex(top.old_, top.oldNext_) : nullptr;
+    auto newEntry = top.newNext_ < newCount ? git_tree_entry_byindex(top.new_, top.newNext_) : nullptr;
+
+    // Entries are merged in git order, where a tree and a blob never share a name
+    int cmp = !oldEntry ? 1 : !newEntry ? -1 : git_tree_entry_cmp(oldEntry, newEntry);
+    if (cmp < 0) {
+      newEntry = nullptr;
+      ++top.oldNext_;
+    } else if (cmp > 0) {
+      oldEntry = nullptr;
+      ++top.newNext_;
+    } else {
+      ++top.oldNext_;
+      ++top.newNext_;
+      if (git_oid_equal(git_tree_entry_id(oldEntry), git_tree_entry_id(newEntry)) &&
+          git_tree_entry_filemode(oldEntry) == git_tree_entry_filemode(newEntry))
+        continue; // Identical, skipped without descending
+    }
+
+    auto entry = newEntry ? newEntry : oldEntry;
+    auto fullpath = top.dir_ / git_tree_entry_name(entry);
+    if (git_tree_entry_type(entry) == GIT_OBJECT_TREE) {
+      auto pushed = push(oldEntry ? git_tree_entry_id(oldEntry) : nullptr,
+                         newEntry ? git_tree_entry_id(newEntry) : nullptr, std::move(fullpath));
+      if (!pushed) {
+        co_yield gd_unexpected(std::move(pushed));
+        co_return;
+      }
+      continue;
+    }
+
+    if (oldEntry && newEntry) {
+      Result<gd::Change> modified = gd::Change{gd::ChangeType::Modified, fullpath, fullpath,
+                                               *git_tree_entry_id(oldEntry), *git_tree_entry_id(newEntry),
+                                               git_tree_entry_filemode(newEntry)};
+      co_yield std::move(modified);
+    } else if (newEntry) {
+      added.push_back({gd::ChangeType::Added, fullpath, fullpath, zero,
+                       *git_tree_entry_id(newEntry), git_tree_entry_filemode(newEntry)});
+    } else {
+      deleted.push_back({gd::ChangeType::Deleted, fullpath, fullpath,
+                         *git_tree_entry_id(oldEntry), zero, git_tree_entry_filemode(oldEntry)});
+    }
+  }
+
+  std::unordered_multimap<std::string, size_t> deletedByOid;
+  for (size_t i = 0; i < deleted.size(); ++i)
+    deletedByOid.emplace(rawOid(deleted[i].oldOid_), i);
+
+  for (auto &change : added) {
+    if (auto itr = deletedByOid.find(rawOid(change.newOid_)); itr != deletedByOid.end()) {
+      auto &gone = deleted[itr->second];
+      change.type_ = gd::ChangeType::Renamed;
+      change.from_ = gone.path_;
+      change.oldOid_ = gone.oldOid_;
+      gone.type_ = gd::ChangeType::Renamed; // Reported by the rename
+      deletedByOid.erase(itr);
+    }
+    co_yield std::move(change);
+  }
+
+  for (auto &change : deleted)
+    if (change.type_ == gd::ChangeType::Deleted)
+      co_yield std::move(change);
+}
+} // namespace
+
+gd::Generator<Result<gd::Change>>
+gd::diff(const gd::Context &ctx, const gd::Revision &from, const gd::Revision &to,
+         const std::filesystem::path &prefix) noexcept {
+  auto normal = normalDir(prefix);
+  return lazyDiff(ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr,
+                  treeAt(ctx, from, normal), treeAt(ctx, to, normal), normal);
+}
+
+/*******************************************************************************
+ *                             Snapshot
+ *     A shared, immutable view of a commit for concurrent readers
+ *******************************************************************************/
+struct gd::Snapshot::State {
+  git_repository *repo_;
+  git_oid commitId_;
+  gd::tree_t root_;
+  gd::odb_t odb_;
+
+  /// @brief Retrieves a directory's tree, loading it once for all readers
+  /// @param dir Normalized directory path, empty for the root
+  /// @param id The directory's tree id when known (i.e. walking), nullptr to resolve it from the root
+  /// @return On success the caller's own handle of the tree, otherwise an Error
+  ///
+  /// NOTE: The cache is bounded, once full it is simply reset, handles given out are unaffected
+  Result<gd::tree_t> dir(const std::filesystem::path &dir, const git_oid *id = nullptr) const noexcept {
+    if (dir.empty())
+      return dup(root_);
+
+    {
+      std::shared_lock<std::shared_mutex> guard(access_);
+      if (auto itr{dirs_.find(dir.string())}; itr != dirs_.end())
+        return dup(itr->second);
+    }
+
+    auto tree = id ? getTree(repo_, id) : getTreeRelativeToRoot(repo_, root_, dir);
+    if (!tree)
+      return gd_unexpected(std::move(tree));
+    if (!*tree)
+      return gd_unexpected(gd::ErrorType::NotFound, "'" + dir.string() + "' not found");
+
+    std::lock_guard<std::shared_mutex> guard(access_);
+    if (dirs_.size() >= sMaxDirs)
+      dirs_.clear();
+    auto [itr, _] = dirs_.try_emplace(dir.string(), std::move(*tree)); // A concurrent load may win
+    return dup(itr->second);
+  }
+
+  mutable std::shared_mutex access_;
+  mutable std::unordered_map<std::string, gd::tree_t> dirs_;
+
+private:
+  static constexpr size_t sMaxDirs{1 << 12};
+
+  static Result<gd::tree_t> dup(git_tree *tree) noexcept {
+    git_tree *copy{nullptr};
+    if (git_tree_dup(&copy, tree) != 0)
+      return gd_unexpected();
+    return gd::tree_t{copy};
+  }
+};
+
+const git_oid &gd::Snapshot::commitId() const noexcept { return state_->commitId_; }
+
+const git_oid &gd::Snapshot::rootId() const noexcept { return *git_tree_id(state_->root_); }
+
+Result<gd::Entry> gd::Snapshot::stat(const std::filesystem::path &fullpath) const noexcept {
+  auto normal = normalDir(fullpath);
+  if (normal.empty()) {
+    auto header = getObjectHeader(state_->odb_, &rootId());
+    if (!header)
+      return gd_unexpected(std::move(header));
+    return gd::Entry{"", GIT_OBJECT_TREE, rootId(), GIT_FILEMODE_TREE, header->first};
+  }
+
+  auto dir = state_->dir(normal.parent_path());
+  if (!dir)
+    return gd_unexpected(std::move(dir));
+
+  auto entry = git_tree_entry_byname(static_cast<git_tree *>(*dir), normal.filename().c_str());
+  if (!entry)
+    return gd_unexpected(gd::ErrorType::NotFound, "'" + normal.string() + "' not found");
+
+  return toEntry(state_->odb_, entry);
+}
+
+Result<std::string> gd::Snapshot::read(const std::filesystem::path &fullpath) const noexcept {
+  auto entry = stat(fullpath);
+  if (!entry)
+    return gd_unexpected(std::move(entry));
+
+  if (entry->type_ != GIT_OBJECT_BLOB)
+    return gd_unexpected(gd::ErrorType::BadFile, fullpath.string() + " is not a file(blob)");
+
+  auto blob = getBlobById(state_->repo_, &entry->oid_);
+  if (!blob)
+    return gd_unexpected(std::move(blob));
+
+  return std::string(static_cast<const char *>(git_blob_rawcontent(*blob)),
+                     git_blob_rawsize(*blob));
+}
+
+gd::Generator<Result<gd::Entry>>
+gd::Snapshot::entries(const std::filesystem::path &dir) const noexcept {
+  auto load = [state = state_](const std::filesystem::path &dir, const git_oid *id) { return state->dir(dir, id); };
+  return lazyEntries(state_->repo_, rootId(), normalDir(dir), {}, {}, std::move(load));
+}
+
+gd::Generator<Result<gd::WalkItem>>
+gd::Snapshot::walk(const std::filesystem::path &prefix, gd::WalkOptions opts) const noexcept {
+  auto load = [state = state_](const std::filesystem::path &dir, const git_oid *id) { return state->dir(dir, id); };
+  return lazyWalk(state_->repo_, rootId(), normalDir(prefix), opts, std::move(load));
+}
+
+namespace {
+/// @brief Creates a snapshot's shared state of a given commit
+Result<gd::Snapshot> snapshotOf(git_repository *repo, const git_oid &commitId) noexcept {
+  auto odb = getOdb(repo);
+  if (!odb)
+    return gd_unexpected(std::move(odb));
+
+  auto root = rootTreeOf(repo, commitId);
+  if (!root)
+    return gd_unexpected(std::move(root));
+
+  auto state = std::make_shared<gd::Snapshot::State>();
+  state->repo_ = repo;
+  state->commitId_ = commitId;
+  state->root_ = std::move(*root);
+  state->odb_ = std::move(*odb);
+
+  sLogger->debug("Snapshot of {}", commitId);
+  return gd::Snapshot{std::move(state)};
+}
+} // namespace
+
+Result<gd::Snapshot> gd::snapshot(const gd::Context &ctx) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  if (!ctx.getCommitId())
+    return gd_unexpected(gd::ErrorType::InitialContext, "Nothing committed to take a snapshot of");
+
+  return snapshotOf(*ctx.repo_, *ctx.getCommitId());
+}
+
+Result<gd::Snapshot> gd::snapshot(const gd::Context &ctx, const gd::Revision &rev) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, sNoRepositoryError);
+
+  auto commitId = resolveRevision(ctx, rev);
+  if (!commitId)
+    return gd_unexpected(std::move(commitId));
+
+  return snapshotOf(*ctx.repo_, *commitId);
+}
+
+namespace {
+/// @brief Loads a subtree, trees are loaded by the walk itself, blobs are looked up and dropped
+Result<size_t> prefetchNow(git_repository *repo, std::optional<git_oid> rootId,
+                           gd::Prefetch what) noexcept {
+  size_t loaded = 0;
+  for (auto &item : lazyWalk(repo, rootId, normalDir(what.prefix_), {gd::WalkOrder::PreOrder, what.depth_})) {
+    if (!item)
+      return gd_unexpected(std::move(item));
+
+    if (!item->isDir() && what.includeBlobs_) {
+      if (auto blob = getBlobById(repo, &item->oid_); !blob)
+        return gd_unexpected(std::move(blob));
+    }
+    loaded += item->isDir() || what.includeBlobs_;
+  }
+
+  sLogger->debug("Prefetched '/{}' ({} objects)", what.prefix_, loaded);
+  return loaded;
+}
+} // namespace
+
+std::future<Result<size_t>> gd::prefetch(const gd::Context &ctx, gd::Prefetch what) noexcept {
+  std::optional<git_oid> rootId;
+  if (ctx.tip_.root_)
+    rootId = *git_tree_id(ctx.tip_.root_);
+
+  // Falls back to a deferred (on get) prefetch if no thread can be started
+  return std::async(std::launch::async | std::launch::deferred, prefetchNow,
+                    ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr,
+                    rootId, std::move(what));
+}
+
+/// @brief Lists a directory, including uncommitted updates
+/// @param ctx The context used to access the repository
+/// @param dir The directory to list
+/// @return On success a context holding the directory's entries, otherwise an
+/// Error
+Result<gd::ListContext>
+gd::ni::list(gd::Context &&ctx, const std::filesystem::path &dir) noexcept {
+  std::vector<Entry> listing;
+  for (auto &entry : entries(ctx, dir)) {
+    if (!entry)
+      return gd_unexpected(std::move(entry));
+
+    listing.emplace_back(std::move(*entry));
+  }
+
+  sLogger->debug("Listed '/{}' ({} entries)", dir, listing.size());
+  return ListContext(std::move(ctx), std::move(listing));
+}
+
+/// @brief Gets thread content, support for thread_local context call chaining
+/// @return The thread_local context
+Result<gd::Context> gd::shorthand::getThreadContext() noexcept {
+  return sGit.threadContext();
+}
+
+Result<gd::Context> &gd::shorthand::threadSession() noexcept {
+  return sGit.threadSession();
+}
+
+void gd::shorthand::resumeSession(gd::Context &ctx) noexcept {
+  sGit.resumeSession(ctx);
+}
+
+Result<void> gd::shorthand::ThreadChainingContext::begin() const noexcept {
+  return sGit.beginSession();
+}
+
+void gd::shorthand::ThreadChainingContext::end() const noexcept {
+  sGit.endSession();
 }
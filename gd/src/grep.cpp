@@ -0,0 +1,296 @@
+#include <gd/grep.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GD_GREP_X86 1
+#endif
+
+namespace {
+using Kernel = void (*)(std::string_view, std::string_view, std::vector<size_t> &) noexcept;
+
+/// @brief Appends the occurrences starting at or after `from`
+void scalarFrom(std::string_view haystack, std::string_view needle, size_t from,
+                std::vector<size_t> &offsets) noexcept {
+  for (auto pos = haystack.find(needle, from); pos != std::string_view::npos; pos = haystack.find(needle, pos + 1))
+    offsets.push_back(pos);
+}
+
+#ifdef GD_GREP_X86
+/// @brief Compares the candidates of a block in full, a candidate's first and last bytes matched the needle's
+inline void verify(uint32_t candidates, std::string_view haystack, size_t pos, std::string_view needle,
+                   std::vector<size_t> &offsets) noexcept {
+  for (; candidates; candidates &= candidates - 1) {
+    auto at = pos + __builtin_ctz(candidates);
+    if (std::memcmp(haystack.data() + at, needle.data(), needle.size()) == 0)
+      offsets.push_back(at);
+  }
+}
+
+/// @brief Compares a block of 32 candidate first bytes and the block of their last bytes with the needle's,
+///        only positions matching both are compared in full. Leftovers shorter than a block are scalar.
+__attribute__((target("avx2")))
+void avx2Kernel(std::string_view haystack, std::string_view needle, std::vector<size_t> &offsets) noexcept {
+  const size_t last = needle.size() - 1;
+  const __m256i first = _mm256_set1_epi8(needle.front());
+  const __m256i final = _mm256_set1_epi8(needle.back());
+
+  size_t pos = 0;
+  for (; pos + last + 32 <= haystack.size(); pos += 32) {
+    auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack.data() + pos));
+    auto lastBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(haystack.data() + pos + last));
+    auto mask = _mm256_and_si256(_mm256_cmpeq_epi8(first, block), _mm256_cmpeq_epi8(final, lastBlock));
+    verify(static_cast<uint32_t>(_mm256_movemask_epi8(mask)), haystack, pos, needle, offsets);
+  }
+  scalarFrom(haystack, needle, pos, offsets);
+}
+
+/// @brief The same on blocks of 16, SSE2 is part of x86-64 thus always available
+void sse2Kernel(std::string_view haystack, std::string_view needle, std::vector<size_t> &offsets) noexcept {
+  const size_t last = needle.size() - 1;
+  const __m128i first = _mm_set1_epi8(needle.front());
+  const __m128i final = _mm_set1_epi8(needle.back());
+
+  size_t pos = 0;
+  for (; pos + last + 16 <= haystack.size(); pos += 16) {
+    auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack.data() + pos));
+    auto lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i *>(haystack.data() + pos + last));
+    auto mask = _mm_and_si128(_mm_cmpeq_epi8(first, block), _mm_cmpeq_epi8(final, lastBlock));
+    verify(static_cast<uint32_t>(_mm_movemask_epi8(mask)), haystack, pos, needle, offsets);
+  }
+  scalarFrom(haystack, needle, pos, offsets);
+}
+#else
+void scalarKernel(std::string_view haystack, std::string_view needle, std::vector<size_t> &offsets) noexcept {
+  scalarFrom(haystack, needle, 0, offsets);
+}
+#endif
+
+struct KernelChoice {
+  Kernel kernel_;
+  const char *name_;
+};
+
+const KernelChoice &kernel() noexcept {
+  static const KernelChoice choice = [] {
+#ifdef GD_GREP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return KernelChoice{avx2Kernel, "avx2"};
+    return KernelChoice{sse2Kernel, "sse2"};
+#else
+    return KernelChoice{scalarKernel, "scalar"};
+#endif
+  }();
+  return choice;
+}
+
+/// @brief A unit of work, a directory to read or a batch of files to search
+struct Work {
+  std::filesystem::path dir_;
+  git_oid tree_;
+  std::vector<std::pair<std::filesystem::path, git_oid>> files_; /* Non empty for a batch of files */
+};
+
+/// @brief State shared by the workers and the consuming generator, guarded by `lock_`
+struct Search {
+  git_repository *repo_;
+  std::vector<std::string> patterns_;
+  gd::GrepOptions opts_;
+
+  std::mutex lock_;
+  std::condition_variable_any changed_;
+  std::vector<Work> work_;                    /* Pending work, taken last in first out (depth first) */
+  size_t busy_{0};                            /* Workers holding work                               */
+  bool failed_{false};
+  std::deque<Result<gd::GrepMatch>> results_;
+
+  bool finished() const noexcept { return failed_ || (work_.empty() && busy_ == 0); }
+};
+
+/// @brief Reads a directory, its subdirectories are queued one by one and its files in batches
+Result<std::vector<Work>> readDir(const Search &search, const Work &work) noexcept {
+  auto tree = getTree(search.repo_, &work.tree_);
+  if (!tree)
+    return gd_unexpected(std::move(tree));
+
+  std::vector<Work> found;
+  Work files{};
+  for (size_t i = 0, count = git_tree_entrycount(*tree); i < count; ++i) {
+    auto entry = git_tree_entry_byindex(*tree, i);
+    auto path = work.dir_ / git_tree_entry_name(entry);
+    if (git_tree_entry_type(entry) == GIT_OBJECT_TREE) {
+      found.push_back({std::move(path), *git_tree_entry_id(entry), {}});
+    } else if (git_tree_entry_type(entry) == GIT_OBJECT_BLOB) {
+      files.files_.emplace_back(std::move(path), *git_tree_entry_id(entry));
+      if (files.files_.size() == search.opts_.batch_)
+        found.push_back(std::exchange(files, Work{}));
+    }
+  }
+  if (!files.files_.empty())
+    found.push_back(std::move(files));
+  return found;
+}
+
+/// @brief Inflates and searches a batch of files
+Result<std::vector<gd::GrepMatch>> searchFiles(const Search &search, git_odb *odb, const Work &work) noexcept {
+  std::vector<gd::GrepMatch> matches;
+  std::vector<size_t> offsets;
+  for (const auto &[path, oid] : work.files_) {
+    git_odb_object *raw{nullptr};
+    if (git_odb_read(&raw, odb, &oid) != 0)
+      return gd_unexpected();
+
+    gd::odb_object_t object{raw};
+    std::string_view content(static_cast<const char *>(git_odb_object_data(object)), git_odb_object_size(object));
+
+    auto first = matches.size();
+    for (size_t pattern = 0; pattern < search.patterns_.size(); ++pattern) {
+      offsets.clear();
+      kernel().kernel_(content, search.patterns_[pattern], offsets);
+      for (auto offset : offsets)
+        matches.push_back({path, offset, pattern});
+    }
+    if (search.patterns_.size() > 1)
+      std::sort(matches.begin() + first, matches.end(), [](const auto &a, const auto &b) {
+        return std::tie(a.offset_, a.pattern_) < std::tie(b.offset_, b.pattern_);
+      });
+  }
+  return matches;
+}
+
+void worker(std::stop_token stop, Search &search) noexcept {
+  auto odb = getOdb(search.repo_);
+
+  std::unique_lock guard(search.lock_);
+  while (search.changed_.wait(guard, stop, [&] { return !search.work_.empty() || search.finished(); })) {
+    if (search.finished())
+      break;
+
+    auto work = std::move(search.work_.back());
+    search.work_.pop_back();
+    ++search.busy_;
+    guard.unlock();
+
+    Result<std::vector<Work>> found = std::vector<Work>{};
+    Result<std::vector<gd::GrepMatch>> matches = std::vector<gd::GrepMatch>{};
+    if (!odb)
+      matches = gd_unexpected(odb.error());
+    else if (work.files_.empty())
+      found = readDir(search, work);
+    else
+      matches = searchFiles(search, *odb, work);
+
+    guard.lock();
+    if (!found || !matches) {
+      search.results_.push_back(gd_unexpected(!found ? found.error() : matches.error()));
+      search.failed_ = true;
+    } else {
+      std::move(found->rbegin(), found->rend(), std::back_inserter(search.work_));
+      search.changed_.notify_all();
+      for (auto &match : *matches) {
+        if (search.results_.size() >= search.opts_.maxPending_) { // Wait for the consumer
+          search.changed_.notify_all();
+          if (!search.changed_.wait(guard, stop, [&] { return search.results_.size() < search.opts_.maxPending_; }))
+            return;
+        }
+        search.results_.push_back(std::move(match));
+      }
+    }
+    --search.busy_; // Only once its matches are queued, not to be seen finished ahead of them
+    search.changed_.notify_all();
+  }
+  search.changed_.notify_all();
+}
+
+/// @brief The lazy grep, its frame owns the workers, joined when the frame is destroyed
+gd::Generator<Result<gd::GrepMatch>>
+lazyGrep(git_repository *repo, Result<git_oid> treeId, std::filesystem::path prefix,
+         std::vector<std::string> patterns, gd::GrepOptions opts) noexcept {
+  if (!treeId) {
+    co_yield gd_unexpected(std::move(treeId));
+    co_return;
+  }
+
+  std::erase_if(patterns, [](const auto &pattern) { return pattern.empty(); });
+  if (patterns.empty())
+    co_return;
+
+  opts.batch_ = std::max<size_t>(opts.batch_, 1);
+  opts.maxPending_ = std::max<size_t>(opts.maxPending_, 1);
+  auto search = std::make_unique<Search>(repo, std::move(patterns), opts);
+  search->work_.push_back({std::move(prefix), *treeId, {}});
+
+  std::vector<std::jthread> workers;
+  auto threads = opts.threads_ ? opts.threads_ : std::max(std::thread::hardware_concurrency(), 1u);
+  for (size_t i = 0; i < threads; ++i)
+    workers.emplace_back(worker, std::ref(*search));
+
+  bool finished = false;
+  while (!finished) {
+    std::deque<Result<gd::GrepMatch>> batch;
+    {
+      std::unique_lock guard(search->lock_);
+      search->changed_.wait(guard, [&] { return !search->results_.empty() || search->finished(); });
+      batch.swap(search->results_);
+      finished = search->finished();
+    }
+    search->changed_.notify_all();
+
+    for (auto &result : batch) {
+      bool failed = !result;
+      co_yield std::move(result);
+      if (failed)
+        co_return;
+    }
+  }
+}
+} // namespace
+
+gd::Generator<Result<gd::GrepMatch>>
+gd::grep(const gd::Context &ctx, const gd::Revision &rev, std::vector<std::string> patterns,
+         const std::filesystem::path &prefix, gd::GrepOptions opts) noexcept {
+  auto normal = prefix.relative_path().lexically_normal();
+  if (normal == ".")
+    normal.clear();
+
+  auto treeId = [&]() -> Result<git_oid> {
+    auto snap = snapshot(ctx, rev);
+    if (!snap)
+      return gd_unexpected(std::move(snap));
+    if (normal.empty())
+      return snap->rootId();
+
+    auto root = getTree(*ctx.repo_, &snap->rootId());
+    if (!root)
+      return gd_unexpected(std::move(root));
+
+    auto tree = getTreeRelativeToRoot(*ctx.repo_, *root, normal);
+    if (!tree)
+      return gd_unexpected(std::move(tree));
+    if (!*tree)
+      return gd_unexpected(gd::ErrorType::NotFound, "'" + normal.string() + "' not found");
+    return *git_tree_id(*tree);
+  }();
+
+  return lazyGrep(ctx.repo_ ? static_cast<git_repository *>(*ctx.repo_) : nullptr, std::move(treeId),
+                  std::move(normal), std::move(patterns), opts);
+}
+
+std::vector<size_t> gd::occurrences(std::string_view haystack, std::string_view needle) noexcept {
+  std::vector<size_t> offsets;
+  if (!needle.empty())
+    kernel().kernel_(haystack, needle, offsets);
+  return offsets;
+}
+
+const char *gd::grepKernel() noexcept {
+  return kernel().name_;
+}
@@ -1,6 +1,7 @@
 #include <git2.h>
 #include <guard.h>
 #include <string.h>
+#include <algorithm>
 #include <out.h>
 
 Result<gd::blob_t>
@@ -180,7 +181,7 @@ contentOf(git_repository* repo, git_oid const * commitId, const std::filesystem:
   if (!resBlob) 
     return gd_unexpected(std::move(resBlob) );
 
-  return std::string(static_cast<const char*>(git_blob_rawcontent(*resBlob)));
+  return std::string(static_cast<const char*>(git_blob_rawcontent(*resBlob)), git_blob_rawsize(*resBlob));
 }
 
 Result<git_oid const *> 
@@ -191,4 +192,97 @@ referenceCommit(git_repository* repo, const std::string& ref) noexcept {
 
     auto oid = git_commit_id(*commitRes); 
     return oid;
-}
\ No newline at end of file
+}
+
+Result<gd::odb_t>
+getOdb(git_repository* repo) noexcept {
+  git_odb* odb{ nullptr };
+  if (git_repository_odb(&odb, repo) != 0)
+    return gd_unexpected();
+
+  return odb;
+}
+
+Result<std::pair<size_t, git_object_t>>
+getObjectHeader(git_odb* odb, git_oid const * oid) noexcept {
+  size_t size{ 0 };
+  git_object_t type{ GIT_OBJECT_INVALID };
+  if (git_odb_read_header(&size, &type, odb, oid) != 0)
+    return gd_unexpected();
+
+  return std::make_pair(size, type);
+}
+
+Result<std::string>
+getBlobRange(git_odb* odb, git_oid const * blobId, size_t offset, size_t length) noexcept {
+  git_odb_stream* raw{ nullptr };
+  size_t size{ 0 };
+  git_object_t type{ GIT_OBJECT_INVALID };
+
+  if (git_odb_open_rstream(&raw, &size, &type, odb, blobId) == 0) {
+    gd::odb_stream_t stream{ raw };
+    if (type != GIT_OBJECT_BLOB)
+      return gd_unexpected(gd::ErrorType::BlobError, "Object is a " + std::string(stringify(type)) + ", not a blob");
+
+    if (offset >= size)
+      return std::string();
+
+    const size_t end = offset + std::min(length, size - offset);
+    std::string content;
+    content.reserve(end - offset);
+
+    char buffer[16 * 1024];
+    for (size_t pos = 0; pos < end; ) {
+      int read = git_odb_stream_read(raw, buffer, sizeof(buffer));
+      if (read < 0)
+        return gd_unexpected();
+      if (read == 0)
+        break;
+
+      const size_t from = std::max(pos, offset);
+      const size_t to = std::min(pos + read, end);
+      if (from < to)
+        content.append(buffer + (from - pos), to - from);
+      pos += read;
+    }
+    return content;
+  }
+
+  // Streaming is supported by loose objects only, a packed (possibly deltified) object is read whole
+  git_error_clear();
+  git_odb_object* object{ nullptr };
+  if (git_odb_read(&object, odb, blobId) != 0)
+    return gd_unexpected();
+
+  gd::odb_object_t guard{ object };
+  if (git_odb_object_type(object) != GIT_OBJECT_BLOB)
+    return gd_unexpected(gd::ErrorType::BlobError, "Object is a " + std::string(stringify(git_odb_object_type(object))) + ", not a blob");
+
+  size = git_odb_object_size(object);
+  if (offset >= size)
+    return std::string();
+
+  return std::string(static_cast<const char*>(git_odb_object_data(object)) + offset, std::min(length, size - offset));
+}
+
+Result<git_oid>
+getCommitByTime(git_repository* repo, git_oid const * from, git_time_t time) noexcept {
+  git_revwalk* walker{ nullptr };
+  if (git_revwalk_new(&walker, repo) != 0)
+    return gd_unexpected();
+
+  gd::revwalk_t walk{ walker };
+  if (git_revwalk_sorting(walk, GIT_SORT_TIME) != 0 || git_revwalk_push(walk, from) != 0)
+    return gd_unexpected();
+
+  git_oid oid;
+  while (git_revwalk_next(&oid, walk) == 0) {
+    auto commit = getCommitById(repo, &oid);
+    if (!commit)
+      return gd_unexpected(std::move(commit));
+
+    if (git_commit_time(*commit) <= time)
+      return oid;
+  }
+  return gd_unexpected(gd::ErrorType::NotFound, "No commit at or before " + std::to_string(time));
+}
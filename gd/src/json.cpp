@@ -0,0 +1,481 @@
+#include <gd/json.h>
+
+#include <cctype>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+constexpr size_t sMaxCachedBytes = 64 * 1024 * 1024; /* Of documents kept for their remembered fields */
+
+struct Span {
+  size_t begin_;
+  size_t end_;
+};
+
+/// @brief Where a field is, or where it would be added to its parent
+struct Location {
+  Span        value_;   /* The field's value, or the empty insertion point  */
+  bool        found_;
+  bool        first_;   /* Added to an empty object or array                */
+  bool        array_;   /* Added to an array, otherwise to an object        */
+  std::string key_;     /* The member added to an object                    */
+};
+
+/// @brief Members passed on the way to a field, by their pointer
+using Visited = std::vector<std::pair<std::string, Span>>;
+
+auto malformed(size_t pos) noexcept {
+  return gd_unexpected(gd::ErrorType::BadFile, "Malformed JSON at offset " + std::to_string(pos));
+}
+
+size_t skipSpace(std::string_view doc, size_t pos) noexcept {
+  while (pos < doc.size() && (doc[pos] == ' ' || doc[pos] == '\t' || doc[pos] == '\n' || doc[pos] == '\r'))
+    ++pos;
+  return pos;
+}
+
+/// @return The position after a string's closing quote, `pos` being its opening one
+Result<size_t> skipString(std::string_view doc, size_t pos) noexcept {
+  for (auto end = pos + 1; end < doc.size(); ++end) {
+    if (doc[end] == '\\')
+      ++end;
+    else if (doc[end] == '"')
+      return end + 1;
+  }
+  return malformed(pos);
+}
+
+/// @return The position after a value, its content is skipped: brackets are balanced but not matched
+Result<size_t> skipValue(std::string_view doc, size_t pos) noexcept {
+  if (pos >= doc.size())
+    return malformed(pos);
+
+  if (doc[pos] == '"')
+    return skipString(doc, pos);
+
+  if (doc[pos] == '{' || doc[pos] == '[') {
+    size_t depth = 0;
+    while (pos < doc.size()) {
+      switch (doc[pos]) {
+      case '"': {
+        auto end = skipString(doc, pos);
+        if (!end)
+          return end;
+        pos = *end;
+        continue;
+      }
+      case '{':
+      case '[':
+        ++depth;
+        break;
+      case '}':
+      case ']':
+        if (--depth == 0)
+          return pos + 1;
+        break;
+      }
+      ++pos;
+    }
+    return malformed(pos);
+  }
+
+  auto end = pos; // A number or a literal
+  while (end < doc.size() && std::string_view(",}] \t\r\n").find(doc[end]) == std::string_view::npos)
+    ++end;
+  if (end == pos)
+    return malformed(pos);
+  return end;
+}
+
+void appendUtf8(std::string &out, uint32_t code) noexcept {
+  if (code < 0x80) {
+    out += static_cast<char>(code);
+  } else if (code < 0x800) {
+    out += static_cast<char>(0xC0 | (code >> 6));
+    out += static_cast<char>(0x80 | (code & 0x3F));
+  } else if (code < 0x10000) {
+    out += static_cast<char>(0xE0 | (code >> 12));
+    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (code >> 18));
+    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code & 0x3F));
+  }
+}
+
+/// @brief Decodes a string's escapes, `raw` being the string without its quotes
+std::string unescape(std::string_view raw) noexcept {
+  if (raw.find('\\') == std::string_view::npos)
+    return std::string(raw);
+
+  auto hex = [&](size_t pos) -> uint32_t {
+    uint32_t code = 0;
+    for (size_t i = pos; i < pos + 4 && i < raw.size(); ++i)
+      code = code * 16 + (std::isdigit(raw[i]) ? raw[i] - '0' : (std::tolower(raw[i]) - 'a' + 10) & 0xF);
+    return code;
+  };
+
+  std::string out;
+  for (size_t pos = 0; pos < raw.size(); ++pos) {
+    if (raw[pos] != '\\' || pos + 1 == raw.size()) {
+      out += raw[pos];
+      continue;
+    }
+    switch (raw[++pos]) {
+    case 'b': out += '\b'; break;
+    case 'f': out += '\f'; break;
+    case 'n': out += '\n'; break;
+    case 'r': out += '\r'; break;
+    case 't': out += '\t'; break;
+    case 'u': {
+      auto code = hex(pos + 1);
+      pos += 4;
+      if (code >= 0xD800 && code < 0xDC00 && pos + 6 < raw.size() && raw.substr(pos + 1, 2) == "\\u") {
+        code = 0x10000 + ((code - 0xD800) << 10) + (hex(pos + 3) - 0xDC00);
+        pos += 6;
+      }
+      appendUtf8(out, code);
+      break;
+    }
+    default: out += raw[pos]; // '"', '\\' and '/'
+    }
+  }
+  return out;
+}
+
+/// @brief Encodes a member's name as a string, without its quotes
+std::string escape(std::string_view name) noexcept {
+  std::string out;
+  for (unsigned char c : name) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (c < 0x20) {
+      constexpr char digits[] = "0123456789abcdef";
+      out += "\\u00";
+      out += digits[c >> 4];
+      out += digits[c & 0xF];
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+/// @brief Encodes a member's name as a pointer token
+std::string tokenOf(std::string_view name) noexcept {
+  std::string token;
+  for (auto c : name)
+    token += c == '~' ? "~0" : c == '/' ? "~1" : std::string(1, c);
+  return token;
+}
+
+/// @brief Splits a JSON pointer into its (decoded) tokens
+Result<std::vector<std::string>> tokensOf(std::string_view pointer) noexcept {
+  std::vector<std::string> tokens;
+  if (pointer.empty())
+    return tokens;
+  if (pointer[0] != '/')
+    return gd_unexpected(gd::ErrorType::Application, "JSON pointer '" + std::string(pointer) + "' doesn't start with '/'");
+
+  for (size_t pos = 1;;) {
+    auto end = std::min(pointer.find('/', pos), pointer.size());
+    std::string token;
+    for (auto i = pos; i < end; ++i) {
+      if (pointer[i] != '~') {
+        token += pointer[i];
+      } else if (i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+        token += pointer[++i] == '0' ? '~' : '/';
+      } else {
+        return gd_unexpected(gd::ErrorType::Application, "Invalid escape in JSON pointer '" + std::string(pointer) + "'");
+      }
+    }
+    tokens.push_back(std::move(token));
+    if (end == pointer.size())
+      return tokens;
+    pos = end + 1;
+  }
+}
+
+/// @return The array index of a token, or nullopt if it isn't one
+std::optional<size_t> indexOf(const std::string &token) noexcept {
+  if (token.empty() || (token.size() > 1 && token[0] == '0') || token.size() > 18 ||
+      token.find_first_not_of("0123456789") != std::string::npos)
+    return std::nullopt;
+  return std::stoull(token);
+}
+
+/// @brief Finds a field in a single pass, the members of objects and arrays on its way are reported to `visited`
+Result<Location> locate(std::string_view doc, const std::vector<std::string> &tokens, Visited *visited) noexcept {
+  auto pos = skipSpace(doc, 0);
+  if (tokens.empty()) {
+    auto end = skipValue(doc, pos);
+    if (!end)
+      return gd_unexpected(std::move(end));
+    if (skipSpace(doc, *end) != doc.size())
+      return malformed(*end);
+    return Location{{pos, *end}, true, false, false, {}};
+  }
+
+  std::string pointer;
+  Span found{pos, pos};
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    const auto &token = tokens[i];
+    const bool last = i + 1 == tokens.size();
+    pos = skipSpace(doc, found.begin_);
+    if (pos >= doc.size() || (doc[pos] != '{' && doc[pos] != '['))
+      return gd_unexpected(gd::ErrorType::NotFound, "'" + pointer + "' has no field '" + token + "'");
+
+    const bool array = doc[pos] == '[';
+    const char close = array ? ']' : '}';
+    auto index = array ? indexOf(token) : std::nullopt;
+
+    bool matched = false;
+    size_t count = 0, lastEnd = pos + 1;
+    pos = skipSpace(doc, pos + 1);
+    if (pos < doc.size() && doc[pos] == close)
+      pos = std::string_view::npos; // Empty
+
+    while (pos != std::string_view::npos) {
+      std::string name;
+      if (!array) {
+        if (pos >= doc.size() || doc[pos] != '"')
+          return malformed(pos);
+        auto nameEnd = skipString(doc, pos);
+        if (!nameEnd)
+          return gd_unexpected(std::move(nameEnd));
+        name = unescape(doc.substr(pos + 1, *nameEnd - pos - 2));
+        pos = skipSpace(doc, *nameEnd);
+        if (pos >= doc.size() || doc[pos] != ':')
+          return malformed(pos);
+        pos = skipSpace(doc, pos + 1);
+      }
+
+      auto end = skipValue(doc, pos);
+      if (!end)
+        return gd_unexpected(std::move(end));
+
+      if (visited)
+        visited->emplace_back(pointer + "/" + (array ? std::to_string(count) : tokenOf(name)), Span{pos, *end});
+
+      if (array ? index == count : name == token) {
+        found = {pos, *end};
+        matched = true;
+        break;
+      }
+
+      ++count;
+      lastEnd = *end;
+      pos = skipSpace(doc, *end);
+      if (pos < doc.size() && doc[pos] == ',')
+        pos = skipSpace(doc, pos + 1);
+      else if (pos < doc.size() && doc[pos] == close)
+        pos = std::string_view::npos;
+      else
+        return malformed(pos);
+    }
+
+    if (!matched) {
+      if (last && (!array || token == "-"))
+        return Location{{lastEnd, lastEnd}, false, count == 0, array, token};
+      return gd_unexpected(gd::ErrorType::NotFound, "'" + pointer + "' has no field '" + token + "'");
+    }
+    pointer += "/" + tokenOf(token);
+  }
+  return Location{found, true, false, false, {}};
+}
+
+/// @brief Documents recently read by a field, and the fields remembered for them, by blob oid
+class FieldCache {
+  struct Document {
+    std::shared_ptr<const std::string>    content_;
+    std::unordered_map<std::string, Span> fields_;
+  };
+
+  std::mutex lock_;
+  std::unordered_map<std::string, Document> documents_;
+  std::deque<std::string> order_; /* Oldest first, evicted first */
+  size_t bytes_ = 0;
+
+  static std::string keyOf(const git_oid &oid) noexcept {
+    return std::string(reinterpret_cast<const char *>(oid.id), GIT_OID_RAWSZ);
+  }
+
+public:
+  /// @return The field's value, or nullopt if it isn't remembered
+  std::optional<std::string> field(const git_oid &oid, std::string_view pointer) noexcept {
+    std::scoped_lock guard(lock_);
+    auto document = documents_.find(keyOf(oid));
+    if (document == documents_.end())
+      return std::nullopt;
+
+    auto found = document->second.fields_.find(std::string(pointer));
+    if (found == document->second.fields_.end())
+      return std::nullopt;
+    return document->second.content_->substr(found->second.begin_, found->second.end_ - found->second.begin_);
+  }
+
+  std::shared_ptr<const std::string> content(const git_oid &oid) noexcept {
+    std::scoped_lock guard(lock_);
+    auto document = documents_.find(keyOf(oid));
+    return document == documents_.end() ? nullptr : document->second.content_;
+  }
+
+  void remember(const git_oid &oid, std::shared_ptr<const std::string> content, Visited &&visited) noexcept {
+    if (content->size() > sMaxCachedBytes)
+      return;
+
+    std::scoped_lock guard(lock_);
+    auto key = keyOf(oid);
+    auto [document, added] = documents_.try_emplace(key);
+    if (added) {
+      document->second.content_ = std::move(content);
+      bytes_ += document->second.content_->size();
+      order_.push_back(key);
+    }
+    for (auto &[pointer, span] : visited)
+      document->second.fields_.insert_or_assign(std::move(pointer), span);
+
+    while (bytes_ > sMaxCachedBytes) {
+      auto oldest = documents_.find(order_.front());
+      bytes_ -= oldest->second.content_->size();
+      documents_.erase(oldest);
+      order_.pop_front();
+    }
+  }
+};
+FieldCache sFields;
+
+/// @brief The content of a file, shared with the cache when the blob was read by a field before
+Result<std::pair<git_oid, std::shared_ptr<const std::string>>>
+documentOf(const gd::Context &ctx, const std::filesystem::path &fullpath) noexcept {
+  auto entry = gd::stat(ctx, fullpath);
+  if (!entry)
+    return gd_unexpected(std::move(entry));
+  if (entry->type_ != GIT_OBJECT_BLOB)
+    return gd_unexpected(gd::ErrorType::BadFile, fullpath.string() + " is not a file(blob)");
+
+  if (auto cached = sFields.content(entry->oid_))
+    return std::make_pair(entry->oid_, std::move(cached));
+
+  auto blob = getBlobById(*ctx.repo_, &entry->oid_);
+  if (!blob)
+    return gd_unexpected(std::move(blob));
+
+  auto content = std::make_shared<const std::string>(static_cast<const char *>(git_blob_rawcontent(*blob)),
+                                                     git_blob_rawsize(*blob));
+  return std::make_pair(entry->oid_, std::move(content));
+}
+} // namespace
+
+Result<std::string_view> gd::jsonField(std::string_view doc, std::string_view pointer) noexcept {
+  auto tokens = tokensOf(pointer);
+  if (!tokens)
+    return gd_unexpected(std::move(tokens));
+
+  auto location = locate(doc, *tokens, nullptr);
+  if (!location)
+    return gd_unexpected(std::move(location));
+  if (!location->found_)
+    return gd_unexpected(gd::ErrorType::NotFound, "No field '" + std::string(pointer) + "'");
+
+  return doc.substr(location->value_.begin_, location->value_.end_ - location->value_.begin_);
+}
+
+Result<std::string> gd::jsonPatch(std::string_view doc, std::string_view pointer, std::string_view value) noexcept {
+  auto begin = skipSpace(value, 0);
+  auto end = skipValue(value, begin);
+  if (!end || skipSpace(value, *end) != value.size())
+    return gd_unexpected(gd::ErrorType::Application, "Invalid JSON value '" + std::string(value) + "'");
+  value = value.substr(begin, *end - begin);
+
+  auto tokens = tokensOf(pointer);
+  if (!tokens)
+    return gd_unexpected(std::move(tokens));
+
+  auto location = locate(doc, *tokens, nullptr);
+  if (!location)
+    return gd_unexpected(std::move(location));
+
+  const auto [from, to] = location->value_;
+  std::string patched(doc.substr(0, from));
+  if (!location->found_) {
+    if (!location->first_)
+      patched += ',';
+    if (!location->array_)
+      patched += "\"" + escape(location->key_) + "\":";
+  }
+  patched += value;
+  patched += doc.substr(to);
+  return patched;
+}
+
+/// @brief Reads a field of a JSON file
+/// @param ctx The context used to access the repository
+/// @param fullpath The fullpath of the file
+/// @param pointer The field's JSON pointer
+/// @return On success a ReadContext with the field's value, otherwise an Error
+Result<gd::ReadContext> gd::ni::readField(gd::Context &&ctx, const std::filesystem::path &fullpath,
+                                          std::string_view pointer) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, "No Repository selected");
+
+  auto tokens = tokensOf(pointer);
+  if (!tokens)
+    return gd_unexpected(std::move(tokens));
+
+  auto entry = stat(ctx, fullpath);
+  if (!entry)
+    return gd_unexpected(std::move(entry));
+
+  if (entry->type_ == GIT_OBJECT_BLOB)
+    if (auto value = sFields.field(entry->oid_, pointer))
+      return ReadContext(std::move(ctx), std::move(*value));
+
+  auto document = documentOf(ctx, fullpath);
+  if (!document)
+    return gd_unexpected(std::move(document));
+
+  auto &[oid, content] = *document;
+  Visited visited;
+  auto location = locate(*content, *tokens, &visited);
+  if (!location) // A malformed document, the fields visited before are not remembered
+    return gd_unexpected(std::move(location));
+
+  if (location->found_ && tokens->empty())
+    visited.emplace_back("", location->value_);
+  sFields.remember(oid, content, std::move(visited));
+
+  if (!location->found_)
+    return gd_unexpected(gd::ErrorType::NotFound, fullpath.string() + " has no field '" + std::string(pointer) + "'");
+
+  const auto [from, to] = location->value_;
+  return ReadContext(std::move(ctx), content->substr(from, to - from));
+}
+
+/// @brief Updates a field of a JSON file, see `jsonPatch`
+/// @param ctx The context used to access the repository
+/// @param fullpath The fullpath of the file
+/// @param pointer The field's JSON pointer
+/// @param value The field's new value
+/// @return On success the context, holding the updated file, otherwise an Error
+Result<gd::Context> gd::ni::patchField(gd::Context &&ctx, const std::filesystem::path &fullpath,
+                                       std::string_view pointer, std::string_view value) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, "No Repository selected");
+
+  auto document = documentOf(ctx, fullpath);
+  if (!document)
+    return gd_unexpected(std::move(document));
+
+  auto patched = jsonPatch(*document->second, pointer, value);
+  if (!patched)
+    return gd_unexpected(std::move(patched));
+
+  return add(std::move(ctx), fullpath, *patched);
+}
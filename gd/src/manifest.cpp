@@ -0,0 +1,365 @@
+#include <gd/manifest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <fcntl.h>
+#include <span>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <out.h>
+
+namespace {
+constexpr char const *sManifestDir = "gd-manifest";
+constexpr char sMagic[4] = {'G', 'D', 'M', 'F'};
+constexpr uint32_t sVersion = 1;
+
+struct Header {
+  char     magic_[4];
+  uint32_t version_;
+  uint64_t count_;
+  git_oid  commit_;
+  char     padding_[4];
+};
+
+struct Record {
+  uint64_t hash_;   /* FNV-1a of the full path           */
+  uint32_t offset_; /* Of the path, from the file's start */
+  uint32_t length_; /* Of the path                        */
+  git_oid  oid_;
+  uint32_t mode_;
+};
+static_assert(sizeof(Header) == 40 && sizeof(Record) == 40, "Manifest layout is fixed");
+
+/// @brief A file to be written, its path is owned either by the parent's mapping or by the writer
+struct Row {
+  uint64_t         hash_;
+  std::string_view path_;
+  git_oid          oid_;
+  uint32_t         mode_;
+};
+
+uint64_t hashOf(std::string_view path) noexcept {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : path) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+template <typename A, typename B>
+bool before(const A &a, const B &b) noexcept {
+  return a.hash_ != b.hash_ ? a.hash_ < b.hash_ : a.path_ < b.path_;
+}
+
+std::filesystem::path manifestPath(git_repository *repo, const git_oid &commitId) noexcept {
+  char hex[GIT_OID_HEXSZ + 1];
+  git_oid_tostr(hex, sizeof(hex), &commitId);
+  return std::filesystem::path(git_repository_path(repo)) / sManifestDir / hex;
+}
+
+std::string normalPath(const std::filesystem::path &fullpath) noexcept {
+  auto normal = fullpath.relative_path().lexically_normal().generic_string();
+  if (normal.ends_with('/'))
+    normal.pop_back();
+  return normal;
+}
+} // namespace
+
+/// @brief A read only mapping of a manifest file
+struct gd::Manifest::Mapping {
+  void  *data_ = MAP_FAILED;
+  size_t size_ = 0;
+
+  Mapping() noexcept = default;
+  Mapping(const Mapping &) = delete;
+  Mapping &operator=(const Mapping &) = delete;
+  ~Mapping() {
+    if (data_ != MAP_FAILED)
+      munmap(data_, size_);
+  }
+
+  const Header &header() const noexcept { return *static_cast<const Header *>(data_); }
+  const Record *records() const noexcept {
+    return reinterpret_cast<const Record *>(static_cast<const char *>(data_) + sizeof(Header));
+  }
+  std::string_view path(const Record &record) const noexcept {
+    return {static_cast<const char *>(data_) + record.offset_, record.length_};
+  }
+
+  static Result<std::shared_ptr<const Mapping>> open(git_repository *repo, const git_oid &commitId) noexcept {
+    auto file = manifestPath(repo, commitId);
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+      return gd_unexpected(gd::ErrorType::NotFound, "No manifest " + file.string());
+
+    auto mapping = std::make_shared<Mapping>();
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header))) {
+      mapping->size_ = st.st_size;
+      mapping->data_ = mmap(nullptr, mapping->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+
+    if (mapping->data_ == MAP_FAILED)
+      return gd_unexpected(gd::ErrorType::BadFile, "Failed mapping manifest " + file.string());
+
+    const auto &header = mapping->header();
+    if (std::memcmp(header.magic_, sMagic, sizeof(sMagic)) != 0 || header.version_ != sVersion ||
+        header.count_ > (mapping->size_ - sizeof(Header)) / sizeof(Record))
+      return gd_unexpected(gd::ErrorType::BadFile, "Malformed manifest " + file.string());
+
+    // Paths follow the records, a path out of the file would be read past the mapping
+    const uint64_t paths = sizeof(Header) + header.count_ * sizeof(Record);
+    for (const auto &record : std::span(mapping->records(), header.count_))
+      if (record.offset_ < paths || uint64_t{record.offset_} + record.length_ > mapping->size_)
+        return gd_unexpected(gd::ErrorType::BadFile, "Malformed manifest " + file.string());
+
+    return mapping;
+  }
+};
+
+namespace {
+/// @brief Appends the files of a tree, at any depth
+Result<void> collect(git_repository *repo, const git_oid &treeId, const std::string &prefix,
+                     std::deque<std::string> &paths, std::vector<Row> &entries) noexcept {
+  std::vector<std::pair<git_oid, std::string>> dirs{{treeId, prefix}};
+  while (!dirs.empty()) {
+    auto [id, dir] = std::move(dirs.back());
+    dirs.pop_back();
+
+    auto tree = getTree(repo, &id);
+    if (!tree)
+      return gd_unexpected(std::move(tree));
+
+    for (size_t i = 0, count = git_tree_entrycount(*tree); i < count; ++i) {
+      auto entry = git_tree_entry_byindex(*tree, i);
+      auto path = dir.empty() ? std::string(git_tree_entry_name(entry)) : dir + "/" + git_tree_entry_name(entry);
+      if (git_tree_entry_type(entry) == GIT_OBJECT_TREE) {
+        dirs.emplace_back(*git_tree_entry_id(entry), std::move(path));
+      } else if (git_tree_entry_type(entry) == GIT_OBJECT_BLOB) {
+        const auto &owned = paths.emplace_back(std::move(path));
+        entries.push_back({hashOf(owned), owned, *git_tree_entry_id(entry),
+                           static_cast<uint32_t>(git_tree_entry_filemode(entry))});
+      }
+    }
+  }
+  return Result<void>();
+}
+
+/// @brief Writes the entries, already in (hash, path) order, replacing the manifest atomically
+Result<void> save(const std::filesystem::path &file, const git_oid &commitId,
+                  const std::vector<Row> &entries) noexcept {
+  std::error_code error;
+  std::filesystem::create_directories(file.parent_path(), error);
+  if (error)
+    return gd_unexpected(gd::ErrorType::BadDir, "Failed creating " + file.parent_path().string() + ": " + error.message());
+
+  auto temporary = file;
+  temporary += ".tmp";
+  std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+  Header header{};
+  std::memcpy(header.magic_, sMagic, sizeof(sMagic));
+  header.version_ = sVersion;
+  header.count_ = entries.size();
+  header.commit_ = commitId;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  uint64_t offset = sizeof(Header) + entries.size() * sizeof(Record);
+  for (const auto &entry : entries) {
+    if (offset + entry.path_.size() > std::numeric_limits<uint32_t>::max())
+      return gd_unexpected(gd::ErrorType::Application, "Manifest paths exceed 4GiB");
+
+    Record record{entry.hash_, static_cast<uint32_t>(offset), static_cast<uint32_t>(entry.path_.size()),
+                  entry.oid_, entry.mode_};
+    out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    offset += entry.path_.size();
+  }
+  for (const auto &entry : entries)
+    out.write(entry.path_.data(), entry.path_.size());
+
+  out.close();
+  if (!out)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed writing manifest " + temporary.string());
+
+  std::filesystem::rename(temporary, file, error);
+  if (error)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed replacing manifest " + file.string() + ": " + error.message());
+  return Result<void>();
+}
+} // namespace
+
+Result<void> gd::internal::writeManifest(git_repository *repo, git_oid const *parentId, const git_oid &commitId,
+                                         const git_tree *root,
+                                         const std::vector<std::filesystem::path> &changed) noexcept {
+  std::deque<std::string> paths;
+  std::vector<Row> entries;
+
+  std::shared_ptr<const Manifest::Mapping> parent;
+  if (parentId) {
+    auto mapping = Manifest::Mapping::open(repo, *parentId);
+    if (mapping)
+      parent = std::move(*mapping);
+    else if (mapping.error()._type != gd::ErrorType::NotFound)
+      return gd_unexpected(std::move(mapping));
+  }
+
+  if (!parent) { // The first manifest, from the entire tree
+    if (auto collected = collect(repo, *git_tree_id(root), "", paths, entries); !collected)
+      return gd_unexpected(std::move(collected));
+
+    std::sort(entries.begin(), entries.end(), before<Row, Row>);
+    return save(manifestPath(repo, commitId), commitId, entries);
+  }
+
+  // Updated paths are read from the new tree, either files or entire directories
+  std::vector<std::string> updated;
+  for (const auto &path : changed)
+    if (auto normal = normalPath(path); !normal.empty())
+      updated.push_back(std::move(normal));
+
+  std::vector<Row> added;
+  for (const auto &path : updated) {
+    git_tree_entry *raw{nullptr};
+    int result = git_tree_entry_bypath(&raw, root, path.c_str());
+    if (result == GIT_ENOTFOUND)
+      continue;
+    if (result != GIT_OK)
+      return gd_unexpected();
+
+    gd::entry_t entry{raw};
+    if (git_tree_entry_type(entry) == GIT_OBJECT_TREE) {
+      if (auto collected = collect(repo, *git_tree_entry_id(entry), path, paths, added); !collected)
+        return gd_unexpected(std::move(collected));
+    } else if (git_tree_entry_type(entry) == GIT_OBJECT_BLOB) {
+      added.push_back({hashOf(path), path, *git_tree_entry_id(entry),
+                       static_cast<uint32_t>(git_tree_entry_filemode(entry))});
+    }
+  }
+  std::sort(added.begin(), added.end(), before<Row, Row>);
+  added.erase(std::unique(added.begin(), added.end(),
+                          [](const auto &a, const auto &b) { return a.path_ == b.path_; }),
+              added.end());
+
+  // The parent's files are kept unless updated, or under an updated directory
+  std::unordered_set<std::string_view> dropped(updated.begin(), updated.end());
+  auto isDropped = [&](std::string_view path) {
+    for (auto end = path.size(); end != std::string_view::npos; end = path.rfind('/', end - 1)) {
+      if (dropped.contains(path.substr(0, end)))
+        return true;
+      if (end == 0)
+        break;
+    }
+    return false;
+  };
+
+  const auto count = parent->header().count_;
+  const auto records = parent->records();
+  entries.reserve(count + added.size());
+  auto next = added.begin();
+  for (size_t i = 0; i < count; ++i) {
+    Row kept{records[i].hash_, parent->path(records[i]), records[i].oid_, records[i].mode_};
+    if (isDropped(kept.path_))
+      continue;
+    for (; next != added.end() && before(*next, kept); ++next)
+      entries.push_back(*next);
+    entries.push_back(kept);
+  }
+  entries.insert(entries.end(), next, added.end());
+
+  return save(manifestPath(repo, commitId), commitId, entries);
+}
+
+Result<gd::Manifest> gd::Manifest::open(const gd::Context &ctx) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, "No Repository selected");
+  if (!ctx.getCommitId())
+    return gd_unexpected(gd::ErrorType::InitialContext, "Nothing was committed yet");
+
+  auto mapping = Mapping::open(*ctx.repo_, *ctx.getCommitId());
+  if (!mapping)
+    return gd_unexpected(std::move(mapping));
+  return Manifest(std::move(*mapping));
+}
+
+Result<gd::Manifest> gd::Manifest::open(const gd::Context &ctx, const gd::Revision &rev) noexcept {
+  auto snap = snapshot(ctx, rev);
+  if (!snap)
+    return gd_unexpected(std::move(snap));
+
+  auto mapping = Mapping::open(*ctx.repo_, snap->commitId());
+  if (!mapping)
+    return gd_unexpected(std::move(mapping));
+  return Manifest(std::move(*mapping));
+}
+
+Result<gd::Manifest::Item> gd::Manifest::find(const std::filesystem::path &fullpath) const noexcept {
+  auto path = normalPath(fullpath);
+  struct Key {
+    uint64_t hash_;
+    std::string_view path_;
+  } key{hashOf(path), path};
+
+  auto records = mapping_->records();
+  auto end = records + mapping_->header().count_;
+  auto found = std::lower_bound(records, end, key, [&](const Record &record, const Key &key) {
+    return before(Key{record.hash_, mapping_->path(record)}, key);
+  });
+
+  if (found == end || found->hash_ != key.hash_ || mapping_->path(*found) != path)
+    return gd_unexpected(gd::ErrorType::NotFound, "'" + path + "' not found");
+  return (*this)[found - records];
+}
+
+size_t gd::Manifest::size() const noexcept {
+  return mapping_->header().count_;
+}
+
+gd::Manifest::Item gd::Manifest::operator[](size_t pos) const noexcept {
+  const auto &record = mapping_->records()[pos];
+  return Item{mapping_->path(record), record.oid_, static_cast<git_filemode_t>(record.mode_)};
+}
+
+const git_oid &gd::Manifest::commitId() const noexcept {
+  return mapping_->header().commit_;
+}
+
+std::vector<gd::Change> gd::diff(const gd::Manifest &from, const gd::Manifest &to) noexcept {
+  git_oid zero;
+  std::memset(&zero, 0, sizeof(zero));
+
+  const auto &a = *from.mapping_, &b = *to.mapping_;
+  const auto aCount = a.header().count_, bCount = b.header().count_;
+  auto key = [](const Manifest::Mapping &mapping, const Record &record) {
+    return std::make_pair(record.hash_, mapping.path(record));
+  };
+
+  std::vector<gd::Change> changes;
+  for (size_t i = 0, j = 0; i < aCount || j < bCount;) {
+    const Record *old = i < aCount ? &a.records()[i] : nullptr;
+    const Record *now = j < bCount ? &b.records()[j] : nullptr;
+    auto mode = [](const Record *record) { return static_cast<git_filemode_t>(record->mode_); };
+
+    if (!now || (old && key(a, *old) < key(b, *now))) {
+      auto path = a.path(*old);
+      changes.push_back({ChangeType::Deleted, path, path, old->oid_, zero, mode(old)});
+      ++i;
+    } else if (!old || key(b, *now) < key(a, *old)) {
+      auto path = b.path(*now);
+      changes.push_back({ChangeType::Added, path, path, zero, now->oid_, mode(now)});
+      ++j;
+    } else {
+      if (!git_oid_equal(&old->oid_, &now->oid_) || old->mode_ != now->mode_) {
+        auto path = b.path(*now);
+        changes.push_back({ChangeType::Modified, path, path, old->oid_, now->oid_, mode(now)});
+      }
+      ++i, ++j;
+    }
+  }
+  return changes;
+}
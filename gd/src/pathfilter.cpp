@@ -0,0 +1,196 @@
+#include <gd/pathfilter.h>
+#include <recordlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+
+namespace {
+constexpr char const *sFiltersFile = "gd-path-filters";
+constexpr gd::internal::LogFormat sFormat{{'G', 'D', 'P', 'F'}, 1, "path filters"};
+constexpr size_t sBitsPerKey = 10;   /* With 7 hashes, about 1% false positives              */
+constexpr size_t sHashes = 7;
+constexpr size_t sMaxKeys = 16'384; /* Larger commits get an empty filter, always a "may have" */
+
+/// @brief Precedes a filter's words
+struct Record {
+  git_oid  commit_;
+  uint32_t count_;  /* Of 64 bit words, 0 when the commit changed too many paths */
+};
+static_assert(sizeof(Record) == 24, "Path filters layout is fixed");
+
+uint64_t hashOf(std::string_view key) noexcept {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/// @brief The second hash of the double hashing, odd to cycle through all the bits
+uint64_t remixOf(uint64_t hash) noexcept {
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+  return (hash ^ (hash >> 31)) | 1;
+}
+
+template <typename Visit>
+void bitsOf(std::string_view key, size_t bits, Visit &&visit) noexcept {
+  auto hash = hashOf(key), step = remixOf(hash);
+  for (size_t i = 0; i < sHashes; ++i, hash += step)
+    visit(hash % bits);
+}
+
+bool contains(uint64_t const *words, size_t count, std::string_view key) noexcept {
+  bool found = true;
+  bitsOf(key, count * 64, [&](size_t bit) { found = found && (words[bit / 64] >> (bit % 64)) & 1; });
+  return found;
+}
+
+std::string normalPath(const std::filesystem::path &fullpath) noexcept {
+  auto normal = fullpath.relative_path().lexically_normal().generic_string();
+  if (normal.ends_with('/'))
+    normal.pop_back();
+  return normal;
+}
+
+std::string filtersPath(git_repository *repo) noexcept {
+  return (std::filesystem::path(git_repository_path(repo)) / sFiltersFile).string();
+}
+
+struct OidHash {
+  size_t operator()(const git_oid &oid) const noexcept {
+    size_t hash;
+    std::memcpy(&hash, oid.id, sizeof(hash));
+    return hash;
+  }
+};
+
+struct OidEqual {
+  bool operator()(const git_oid &a, const git_oid &b) const noexcept { return git_oid_equal(&a, &b); }
+};
+} // namespace
+
+namespace {
+/// @brief The filters of a load, see `RecordLog`
+struct FilterSegment {
+  std::vector<uint64_t> words_;
+  std::unordered_map<git_oid, std::pair<size_t, size_t>, OidHash, OidEqual> filters_; /* (first word, count) */
+
+  size_t read(std::string_view records) noexcept {
+    size_t pos = 0;
+    Record record;
+    while (records.size() - pos >= sizeof(record)) {
+      std::memcpy(&record, records.data() + pos, sizeof(record));
+      auto bytes = size_t(record.count_) * sizeof(uint64_t);
+      if (records.size() - pos - sizeof(record) < bytes)
+        break;
+
+      auto first = words_.size();
+      words_.resize(first + record.count_);
+      std::memcpy(words_.data() + first, records.data() + pos + sizeof(record), bytes);
+      filters_.insert_or_assign(record.commit_, std::make_pair(first, size_t(record.count_)));
+      pos += sizeof(record) + bytes;
+    }
+    return pos;
+  }
+
+  void append(const FilterSegment &newer) noexcept {
+    auto shift = words_.size();
+    words_.insert(words_.end(), newer.words_.begin(), newer.words_.end());
+    for (const auto &[commit, at] : newer.filters_)
+      filters_.insert_or_assign(commit, std::make_pair(at.first + shift, at.second));
+  }
+
+  size_t size() const noexcept { return filters_.size(); }
+};
+} // namespace
+
+struct gd::PathFilterTable : gd::internal::LogTable<FilterSegment> {};
+
+namespace {
+gd::internal::RecordLog<gd::PathFilterTable> sFilters(sFormat);
+} // namespace
+
+bool gd::PathFilter::mayHaveChanged(const std::filesystem::path &fullpath) const noexcept {
+  auto path = normalPath(fullpath);
+  if (count_ == 0 || path.empty() || contains(words_, count_, path))
+    return true;
+
+  // Or an updated directory holding it
+  for (auto end = path.rfind('/'); end != std::string::npos; end = end ? path.rfind('/', end - 1) : std::string::npos)
+    if (contains(words_, count_, path.substr(0, end + 1)))
+      return true;
+  return false;
+}
+
+Result<gd::PathFilters> gd::PathFilters::open(const gd::Context &ctx) noexcept {
+  if (!ctx.repo_)
+    return gd_unexpected(gd::ErrorType::MissingRepository, "No Repository selected");
+
+  auto table = sFilters.open(filtersPath(*ctx.repo_));
+  if (!table)
+    return gd_unexpected(std::move(table));
+  return PathFilters(std::move(*table));
+}
+
+std::optional<gd::PathFilter> gd::PathFilters::find(const git_oid &commitId) const noexcept {
+  for (auto segment = table_->segments_.rbegin(); segment != table_->segments_.rend(); ++segment)
+    if (auto found = (*segment)->filters_.find(commitId); found != (*segment)->filters_.end()) {
+      auto [first, count] = found->second;
+      return PathFilter((*segment)->words_.data() + first, count);
+    }
+  return std::nullopt;
+}
+
+bool gd::PathFilters::mayHaveChanged(const git_oid &commitId, const std::filesystem::path &fullpath) const noexcept {
+  auto filter = find(commitId);
+  return !filter || filter->mayHaveChanged(fullpath);
+}
+
+size_t gd::PathFilters::size() const noexcept {
+  size_t size = 0;
+  for (const auto &segment : table_->segments_)
+    size += segment->size();
+  return size;
+}
+
+Result<void> gd::internal::writePathFilter(git_repository *repo, const git_oid &commitId,
+                                           const std::vector<std::filesystem::path> &changed) noexcept {
+  std::set<std::string> keys;
+  for (const auto &fullpath : changed) {
+    auto path = normalPath(fullpath);
+    if (path.empty())
+      continue;
+
+    keys.insert(path + "/");
+    for (auto end = path.size(); end != std::string::npos; end = path.rfind('/', end - 1))
+      keys.insert(path.substr(0, end));
+  }
+
+  Record record{commitId, 0};
+  if (keys.size() <= sMaxKeys)
+    record.count_ = static_cast<uint32_t>(std::max<size_t>(1, (keys.size() * sBitsPerKey + 63) / 64));
+
+  std::vector<uint64_t> words(record.count_);
+  if (!words.empty())
+    for (const auto &key : keys)
+      bitsOf(key, words.size() * 64, [&](size_t bit) { words[bit / 64] |= uint64_t(1) << (bit % 64); });
+
+  std::string buffer(reinterpret_cast<const char *>(&record), sizeof(record));
+  buffer.append(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(uint64_t));
+  return sFilters.append(filtersPath(repo), buffer);
+}
+
+Result<gd::PathFilters> gd::internal::currentPathFilters(git_repository *repo) noexcept {
+  auto table = sFilters.current(filtersPath(repo));
+  if (!table)
+    return gd_unexpected(std::move(table));
+  return PathFilters(std::move(*table));
+}
+
+void gd::internal::dropPathFilters(git_repository *repo) noexcept {
+  sFilters.drop(filtersPath(repo));
+}
@@ -0,0 +1,62 @@
+#include <recordlog.h>
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+struct Header {
+  char     magic_[4];
+  uint32_t version_;
+};
+static_assert(sizeof(Header) == gd::internal::sLogHeaderSize, "Record file layout is fixed");
+} // namespace
+
+Result<void> gd::internal::appendRecord(const std::string &file, const LogFormat &format,
+                                        std::string_view record) noexcept {
+  int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd < 0)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed opening " + file);
+
+  std::string buffer;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size == 0) {
+    Header header;
+    std::memcpy(header.magic_, format.magic_, sizeof(header.magic_));
+    header.version_ = format.version_;
+    buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  buffer.append(record);
+
+  // A single append, concurrent readers see either none or all of the record
+  auto written = ::write(fd, buffer.data(), buffer.size());
+  ::close(fd);
+  if (written != static_cast<ssize_t>(buffer.size()))
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed appending to " + file);
+  return Result<void>();
+}
+
+Result<std::string> gd::internal::readRecords(const std::string &file, const LogFormat &format, off_t from,
+                                              off_t to) noexcept {
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0)
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed opening " + file);
+
+  std::string records(to - from, '\0');
+  auto read = ::pread(fd, records.data(), records.size(), from);
+  ::close(fd);
+  if (read != static_cast<ssize_t>(records.size()))
+    return gd_unexpected(gd::ErrorType::BadFile, "Failed reading " + file);
+
+  if (from == 0) {
+    Header header;
+    if (records.size() < sizeof(header))
+      return gd_unexpected(gd::ErrorType::BadFile, "Malformed " + std::string(format.name_) + " " + file);
+
+    std::memcpy(&header, records.data(), sizeof(header));
+    if (std::memcmp(header.magic_, format.magic_, sizeof(header.magic_)) != 0 || header.version_ != format.version_)
+      return gd_unexpected(gd::ErrorType::BadFile, "Malformed " + std::string(format.name_) + " " + file);
+    records.erase(0, sizeof(header));
+  }
+  return records;
+}
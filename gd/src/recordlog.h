@@ -0,0 +1,157 @@
+#pragma once
+#include <expected.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+
+/**
+ * Append only record files, kept next to a repository's objects (i.e. path filters, commit index)
+ *
+ * A file starts with a header (magic and version) written by the first append, then records. A record is
+ * appended by a single write, concurrent readers see either none or all of it, a partly written record is
+ * read by a later load.
+ *
+ * A loaded file is an immutable table of segments, the records read by a load are a new segment. A new
+ * segment is merged with the newest ones while they aren't larger, so a table has a logarithmic number of
+ * segments and a grown table shares the records loaded before, instead of copying them.
+ **/
+namespace gd::internal
+{
+  struct LogFormat {
+    char        magic_[4];
+    uint32_t    version_;
+    char const* name_;     /* Of the file's content, for errors */
+  };
+
+  /// @brief The records of a file, immutable once published
+  /// @tparam S The records of a load, with:
+  ///           - `size_t read(std::string_view records)` reading whole records, returning the bytes read
+  ///           - `void append(const S& newer)` adding the records of a later load
+  ///           - `size_t size() const` the number of records
+  template <typename S>
+  struct LogTable {
+    using Segment = S;
+
+    ino_t                                       inode_ = 0;
+    off_t                                       loaded_ = 0; /* Bytes of whole records read, with the header */
+    std::vector<std::shared_ptr<const Segment>> segments_;   /* Oldest first                                */
+  };
+
+  /// @brief Appends a record to a file, created with its header by the first append
+  /// @return On success nothing, otherwise an Error
+  Result<void> appendRecord(const std::string& file, const LogFormat& format, std::string_view record) noexcept;
+
+  /// @brief Reads a file's bytes in [from, to), the header is checked and skipped when reading from the start
+  /// @return On success the records' bytes, otherwise an Error
+  Result<std::string> readRecords(const std::string& file, const LogFormat& format, off_t from, off_t to) noexcept;
+
+  constexpr off_t sLogHeaderSize = 8;
+
+  /// @brief The loaded tables of a kind of record file, per file
+  /// @tparam Table A `LogTable`
+  template <typename Table>
+  class RecordLog {
+    using Segment = typename Table::Segment;
+
+    struct Loaded {
+      std::shared_ptr<const Table> table_;
+      bool                         appended_ = false; /* By this process, since the table was loaded */
+    };
+
+    LogFormat                     format_;
+    std::mutex                    access_;
+    std::mutex                    writeAccess_; /* The header is written once, by the first writer */
+    std::map<std::string, Loaded> tables_;
+
+    static void add(Table& table, std::shared_ptr<Segment> segment) noexcept {
+      while (!table.segments_.empty() && table.segments_.back()->size() <= segment->size()) {
+        auto merged = std::make_shared<Segment>(*table.segments_.back());
+        merged->append(*segment);
+        table.segments_.pop_back();
+        segment = std::move(merged);
+      }
+      table.segments_.push_back(std::move(segment));
+    }
+
+    public:
+    explicit RecordLog(LogFormat format) noexcept
+    : format_{ format } {}
+
+    /// @brief Loads the records appended to a file since its last load
+    /// @return On success the table, empty when there is no file, otherwise an Error
+    Result<std::shared_ptr<const Table>> open(const std::string& file) noexcept {
+      std::scoped_lock guard(access_);
+      auto& loaded = tables_[file];
+      loaded.appended_ = false;
+
+      struct stat st;
+      if (::stat(file.c_str(), &st) != 0) {
+        loaded.table_ = std::make_shared<const Table>();
+        return loaded.table_;
+      }
+
+      const auto& cached = loaded.table_;
+      if (cached && cached->inode_ == st.st_ino && cached->loaded_ == st.st_size)
+        return cached;
+
+      // A grown file is read from where it was left, otherwise (i.e. recreated) from its start
+      auto table = std::make_shared<Table>();
+      if (cached && cached->inode_ == st.st_ino && cached->loaded_ < st.st_size) {
+        table->loaded_ = cached->loaded_;
+        table->segments_ = cached->segments_;
+      }
+      table->inode_ = st.st_ino;
+
+      if (table->loaded_ > 0 || st.st_size >= sLogHeaderSize) {
+        auto records = readRecords(file, format_, table->loaded_, st.st_size);
+        if (!records)
+          return gd_unexpected(std::move(records));
+
+        auto segment = std::make_shared<Segment>();
+        table->loaded_ += (table->loaded_ == 0 ? sLogHeaderSize : 0) + segment->read(*records);
+        if (segment->size() > 0)
+          add(*table, std::move(segment));
+      }
+
+      loaded.table_ = table;
+      return loaded.table_;
+    }
+
+    /// @brief The last loaded table of a file, reloaded only when this process appended to it since
+    ///
+    /// NOTE: Records appended by other processes are seen by `open`
+    Result<std::shared_ptr<const Table>> current(const std::string& file) noexcept {
+      {
+        std::scoped_lock guard(access_);
+        if (auto found = tables_.find(file); found != tables_.end() && found->second.table_ && !found->second.appended_)
+          return found->second.table_;
+      }
+      return open(file);
+    }
+
+    /// @brief Appends a record, see `appendRecord`
+    Result<void> append(const std::string& file, std::string_view record) noexcept {
+      {
+        std::scoped_lock serialize(writeAccess_);
+        if (auto appended = appendRecord(file, format_, record); !appended)
+          return appended;
+      }
+      std::scoped_lock guard(access_);
+      if (auto found = tables_.find(file); found != tables_.end())
+        found->second.appended_ = true;
+      return Result<void>();
+    }
+
+    /// @brief Forgets the loaded table of a file, i.e. when its repository is removed
+    void drop(const std::string& file) noexcept {
+      std::scoped_lock guard(access_);
+      tables_.erase(file);
+    }
+  };
+}
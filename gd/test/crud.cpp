@@ -7,8 +7,18 @@
 #include <algorithm>
 #include <iostream>
 #include <gd/gd.h>
+#include <gd/fulltext.h>
+#include <gd/grep.h>
+#include <gd/async.h>
+#include <gd/commits.h>
+#include <gd/json.h>
+#include <gd/manifest.h>
+#include <gd/pathfilter.h>
 #include <tuple>
 #include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
 
 using namespace std;
 using namespace std::filesystem;
@@ -576,4 +586,1315 @@ TEST_CASE("Sanitize", "[sanitize]") {
       REQUIRE(!result == false);
     }
   }
-}
\ No newline at end of file
+}
+TEST_CASE("list", "[query] [list]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto names = [](const std::vector<Entry>& entries) {
+    std::vector<string> names;
+    for (const auto& entry : entries)
+      names.push_back(entry.name_);
+    return names;
+  };
+
+  SECTION("committed entries with sizes") {
+    auto result = selectRepository(testRepoPath)
+    >> add("README", "test text")
+    >> add("docs/a", "aaa")
+    >> commit("test", "test@test.com", "commit message")
+    >> list("");
+
+    REQUIRE(!result == false);
+    REQUIRE(names(result->entries()) == std::vector<string>{"README", "docs"});
+    REQUIRE(result->entries()[0].type_ == GIT_OBJECT_BLOB);
+    REQUIRE(result->entries()[0].size_ == 9);
+    REQUIRE(result->entries()[1].type_ == GIT_OBJECT_TREE);
+  }
+
+  SECTION("uncommitted adds and deletes are merged") {
+    auto result = selectRepository(testRepoPath)
+    >> add("docs/a", "aaa")
+    >> add("docs/b", "bbb")
+    >> commit("test", "test@test.com", "commit message")
+    >> del("docs/a")
+    >> add("docs/c", "cccc")
+    >> add("docs/new/d", "d")
+    >> list("docs/");
+
+    REQUIRE(!result == false);
+    REQUIRE(names(result->entries()) == std::vector<string>{"b", "c", "new"});
+    REQUIRE(result->entries()[1].size_ == 4);
+    REQUIRE(git_oid_iszero(&result->entries()[2].oid_));
+  }
+
+  SECTION("lazy entries") {
+    auto ctx = selectRepository(testRepoPath)
+    >> add("many/0", "0")
+    >> add("many/1", "1")
+    >> add("many/2", "2")
+    >> commit("test", "test@test.com", "commit message");
+
+    REQUIRE(!ctx == false);
+    size_t count = 0;
+    for (const auto& entry : entries(*ctx, "many")) {
+      REQUIRE(!entry == false);
+      REQUIRE(entry->name_ == std::to_string(count++));
+    }
+    REQUIRE(count == 3);
+  }
+
+  SECTION("removed directories") {
+    auto ctx = selectRepository(testRepoPath)
+    >> add("a/x", "x")
+    >> add("a/y", "y")
+    >> add("b", "b")
+    >> commit("test", "test@test.com", "commit message")
+    >> del("a");
+
+    auto listed = [&](const std::string& dir) {
+      std::vector<string> names;
+      for (const auto& entry : entries(*ctx, dir))
+        names.push_back(entry ? entry->name_ : "");
+      return names;
+    };
+    REQUIRE(listed("") == std::vector<string>{"b"});
+    REQUIRE(listed("a") == std::vector<string>{""});
+
+    // Recreated by an update below it, without its committed entries
+    ctx >> add("a/z", "z");
+    REQUIRE(listed("") == std::vector<string>{"b", "a"});
+    REQUIRE(listed("a") == std::vector<string>{"z"});
+    REQUIRE(stat(*ctx, "a/x").error()._type == ErrorType::Deleted);
+
+    ctx >> commit("test", "test@test.com", "recreated");
+    REQUIRE(!ctx == false);
+    REQUIRE(listed("a") == std::vector<string>{"z"});
+  }
+
+  SECTION("unknown directory") {
+    auto result = selectRepository(testRepoPath)
+    >> add("README", "test text")
+    >> commit("test", "test@test.com", "commit message")
+    >> list("nowhere");
+
+    REQUIRE(!result == true);
+    REQUIRE(result.error()._type == ErrorType::NotFound);
+  }
+}
+
+TEST_CASE("walk", "[query] [walk]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("a/b/c", "abc")
+  >> add("a/d", "ad")
+  >> add("e", "e")
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  auto paths = [](auto&& items) {
+    std::vector<string> paths;
+    for (const auto& item : items) {
+      REQUIRE(!item == false);
+      paths.push_back(item->path_.string());
+    }
+    return paths;
+  };
+
+  SECTION("pre order") {
+    REQUIRE(paths(walk(*ctx)) == std::vector<string>{"a", "a/b", "a/b/c", "a/d", "e"});
+  }
+
+  SECTION("post order") {
+    REQUIRE(paths(walk(*ctx, "", {WalkOrder::PostOrder})) == std::vector<string>{"a/b/c", "a/b", "a/d", "a", "e"});
+  }
+
+  SECTION("prefix and depth limit") {
+    REQUIRE(paths(walk(*ctx, "a/", {WalkOrder::PreOrder, 1})) == std::vector<string>{"a/b", "a/d"});
+  }
+
+  SECTION("lazy content") {
+    for (const auto& item : walk(*ctx, "a")) {
+      REQUIRE(!item == false);
+      if (item->path_ == "a/d")
+        REQUIRE(item->content().value() == "ad");
+      if (item->isDir())
+        REQUIRE(!item->content() == true);
+    }
+  }
+
+  SECTION("unknown prefix") {
+    auto gen = walk(*ctx, "nowhere");
+    auto itr = gen.begin();
+    REQUIRE(itr != std::default_sentinel);
+    REQUIRE((*itr).error()._type == ErrorType::NotFound);
+  }
+}
+
+TEST_CASE("readAt", "[query] [readAt]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("doc", "v1")
+  >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+  git_oid first = *ctx->getCommitId();
+
+  ctx = std::move(ctx)
+  >> add("doc", string("v2\0with nul", 11))
+  >> commit("test", "test@test.com", "second");
+  REQUIRE(!ctx == false);
+  git_oid second = *ctx->getCommitId();
+
+  SECTION("by revision string") {
+    auto result = std::move(ctx) >> readAt("doc", "HEAD~1");
+    REQUIRE(!result == false);
+    REQUIRE(result->content() == "v1");
+    REQUIRE(git_oid_equal(result->getCommitId(), &second));
+  }
+
+  SECTION("by commit id, twice to use the cache") {
+    auto result = std::move(ctx) >> readAt("doc", first) >> readAt("doc", first);
+    REQUIRE(!result == false);
+    REQUIRE(result->content() == "v1");
+  }
+
+  SECTION("by time, content with NUL") {
+    auto result = std::move(ctx) >> readAt("doc", std::chrono::system_clock::now());
+    REQUIRE(!result == false);
+    REQUIRE(result->content().size() == 11);
+
+    result = std::move(result) >> readAt("doc", std::chrono::system_clock::time_point{});
+    REQUIRE(!result == true);
+    REQUIRE(result.error()._type == ErrorType::NotFound);
+  }
+}
+
+TEST_CASE("history", "[query] [history]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/x", "v1")
+  >> commit("first", "first@test.com", "x v1")
+  >> add("docs/y", "y")
+  >> add("other", "o")
+  >> commit("test", "test@test.com", "unrelated")
+  >> add("docs/x", "v2")
+  >> commit("second", "second@test.com", "x v2");
+  REQUIRE(!ctx == false);
+
+  auto versions = [](auto&& gen) {
+    std::vector<string> authors;
+    for (const auto& version : gen) {
+      REQUIRE(!version == false);
+      authors.push_back(version->author_);
+    }
+    return authors;
+  };
+
+  SECTION("all versions, newest first") {
+    REQUIRE(versions(history(*ctx, "docs/x")) == std::vector<string>{"second", "first"});
+  }
+
+  SECTION("blob of a version") {
+    for (const auto& version : history(*ctx, "docs/x", {1})) {
+      REQUIRE(!version == false);
+      auto result = std::move(ctx) >> readAt("docs/x", version->commit_);
+      REQUIRE(result->content() == "v2");
+      REQUIRE(version->email_ == "second@test.com");
+    }
+  }
+
+  SECTION("limit and since") {
+    REQUIRE(versions(history(*ctx, "docs/x", {1})).size() == 1);
+    HistoryOptions future{.since_ = std::chrono::system_clock::now() + std::chrono::hours(1)};
+    REQUIRE(versions(history(*ctx, "docs/x", future)).empty());
+    HistoryOptions past{.until_ = std::chrono::system_clock::time_point{}};
+    REQUIRE(versions(history(*ctx, "docs/x", past)).empty());
+  }
+
+  SECTION("unknown file has no versions") {
+    REQUIRE(versions(history(*ctx, "docs/none")).empty());
+  }
+}
+
+TEST_CASE("diff", "[query] [diff]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("same/a", "a")
+  >> add("docs/keep", "keep")
+  >> add("docs/change", "v1")
+  >> add("docs/gone", "gone")
+  >> add("docs/old", "moved")
+  >> commit("test", "test@test.com", "first")
+  >> add("docs/change", "v2")
+  >> del("docs/gone")
+  >> mv("docs/old", "docs/sub/new")
+  >> add("docs/added", "added")
+  >> commit("test", "test@test.com", "second");
+  REQUIRE(!ctx == false);
+
+  auto changes = [](auto&& gen) {
+    std::map<string, std::pair<ChangeType, string>> changes;
+    for (const auto& change : gen) {
+      REQUIRE(!change == false);
+      changes[change->path_.string()] = {change->type_, change->from_.string()};
+    }
+    return changes;
+  };
+
+  SECTION("added, modified, deleted and renamed") {
+    auto result = changes(diff(*ctx, "HEAD~1", "HEAD"));
+    REQUIRE(result.size() == 4);
+    REQUIRE(result["docs/change"].first == ChangeType::Modified);
+    REQUIRE(result["docs/added"].first == ChangeType::Added);
+    REQUIRE(result["docs/gone"].first == ChangeType::Deleted);
+    REQUIRE(result["docs/sub/new"] == std::pair<ChangeType, string>{ChangeType::Renamed, "docs/old"});
+  }
+
+  SECTION("prefix") {
+    REQUIRE(changes(diff(*ctx, "HEAD~1", "HEAD", "same")).empty());
+    REQUIRE(changes(diff(*ctx, "HEAD~1", "HEAD", "docs/sub")).size() == 1);
+  }
+
+  SECTION("bad revision") {
+    auto gen = diff(*ctx, "nowhere", "HEAD");
+    auto itr = gen.begin();
+    REQUIRE(itr != std::default_sentinel);
+    REQUIRE(!*itr == true);
+  }
+}
+
+TEST_CASE("stat", "[query] [stat]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/a", "aaa")
+  >> add("docs/b", "bb")
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  SECTION("committed file and directory") {
+    auto entry = stat(*ctx, "docs/a");
+    REQUIRE(!entry == false);
+    REQUIRE(entry->type_ == GIT_OBJECT_BLOB);
+    REQUIRE(entry->size_ == 3);
+    REQUIRE(stat(*ctx, "docs/")->type_ == GIT_OBJECT_TREE);
+    REQUIRE(stat(*ctx, "")->type_ == GIT_OBJECT_TREE);
+    REQUIRE(exists(*ctx, "docs/none").value() == false);
+  }
+
+  SECTION("uncommitted updates") {
+    ctx = std::move(ctx)
+    >> add("docs/a", "aaaa")
+    >> add("new/c", "c")
+    >> del("docs/b");
+    REQUIRE(!ctx == false);
+
+    REQUIRE(stat(*ctx, "docs/a")->size_ == 4);
+    REQUIRE(stat(*ctx, "new/c")->size_ == 1);
+    REQUIRE(stat(*ctx, "new")->type_ == GIT_OBJECT_TREE);
+    REQUIRE(stat(*ctx, "docs/b").error()._type == ErrorType::Deleted);
+    REQUIRE(exists(*ctx, "docs/b").value() == false);
+  }
+
+  SECTION("deleted directory") {
+    ctx = std::move(ctx) >> del("docs");
+    REQUIRE(!ctx == false);
+    REQUIRE(exists(*ctx, "docs/a").value() == false);
+  }
+
+  SECTION("moved directory") {
+    ctx = std::move(ctx) >> mv("docs", "moved");
+    REQUIRE(!ctx == false);
+    REQUIRE(stat(*ctx, "moved/a")->size_ == 3);
+    REQUIRE(exists(*ctx, "docs/a").value() == false);
+
+    ctx = std::move(ctx) >> add("other/c", "c") >> commit("test", "test@test.com", "other") >> mv("other", "moved");
+    REQUIRE(!ctx == false);
+    REQUIRE(stat(*ctx, "moved/c")->size_ == 1);
+    REQUIRE(exists(*ctx, "moved/a").value() == false);
+  }
+}
+
+TEST_CASE("snapshot", "[query] [snapshot]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/a", "v1")
+  >> add("docs/b", "b")
+  >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+
+  auto snap = snapshot(*ctx);
+  REQUIRE(!snap == false);
+
+  SECTION("reads are isolated from later commits") {
+    ctx = std::move(ctx)
+    >> add("docs/a", "v2")
+    >> commit("test", "test@test.com", "second");
+    REQUIRE(!ctx == false);
+
+    Snapshot copy = *snap;
+    REQUIRE(copy.read("docs/a").value() == "v1");
+    REQUIRE(copy.stat("docs/b")->size_ == 1);
+    REQUIRE(copy.read("docs").error()._type == ErrorType::BadFile);
+    REQUIRE(snapshot(*ctx, "HEAD~1")->read("docs/a").value() == "v1");
+    REQUIRE(snapshot(*ctx)->read("docs/a").value() == "v2");
+  }
+
+  SECTION("shared by threads") {
+    std::vector<std::thread> readers;
+    std::atomic<int> good{0};
+    for (int i = 0; i < 8; ++i)
+      readers.emplace_back([copy = *snap, &good] {
+        for (int j = 0; j < 50; ++j)
+          if (copy.read("docs/a").value_or("") == "v1" && copy.read("docs/b").value_or("") == "b")
+            ++good;
+      });
+
+    for (auto& reader : readers)
+      reader.join();
+    REQUIRE(good == 8 * 50);
+  }
+
+  SECTION("lazy queries") {
+    size_t count = 0;
+    for (const auto& item : snap->walk())
+      count += !!item;
+    REQUIRE(count == 3);
+
+    size_t listed = 0;
+    for (const auto& entry : snap->entries("docs"))
+      listed += !!entry;
+    REQUIRE(listed == 2);
+
+    // Directories come from the snapshot's shared cache, kept alive by the walk
+    auto walk = Snapshot(*snap).walk("docs");
+    size_t walked = 0;
+    for (const auto& item : walk)
+      walked += !!item;
+    REQUIRE(walked == 2);
+  }
+}
+
+TEST_CASE("by id", "[crud] [byId]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/large", "shared content")
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  git_oid blobId = stat(*ctx, "docs/large")->oid_;
+
+  SECTION("read by id") {
+    auto result = std::move(ctx) >> readById(blobId);
+    REQUIRE(!result == false);
+    REQUIRE(result->content() == "shared content");
+  }
+
+  SECTION("add by id") {
+    auto result = std::move(ctx)
+    >> addById("other/link", blobId)
+    >> commit("test", "test@test.com", "link")
+    >> read("other/link");
+    REQUIRE(!result == false);
+    REQUIRE(result->content() == "shared content");
+  }
+
+  SECTION("add by id of a tree or an unknown object") {
+    git_oid treeId = stat(*ctx, "docs")->oid_;
+    auto result = std::move(ctx) >> addById("bad", treeId);
+    REQUIRE(!result == true);
+    REQUIRE(result.error()._type == ErrorType::BadFile);
+
+    git_oid unknown;
+    git_oid_fromstr(&unknown, "0123456789012345678901234567890123456789");
+    REQUIRE(!(selectRepository(testRepoPath) >> addById("bad", unknown)) == true);
+  }
+}
+
+TEST_CASE("prefetch", "[query] [prefetch]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("hot/a/1", "1")
+  >> add("hot/a/2", "2")
+  >> add("hot/b", "b")
+  >> add("cold/c", "c")
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  SECTION("trees, blobs and depth") {
+    REQUIRE(prefetch(*ctx, {"hot"}).get().value() == 1);
+    REQUIRE(prefetch(*ctx, {"hot", 1, true}).get().value() == 2);
+    REQUIRE(prefetch(*ctx, {"", std::numeric_limits<size_t>::max(), true}).get().value() == 7);
+    REQUIRE(!prefetch(*ctx, {"nowhere"}).get() == true);
+  }
+
+  SECTION("warm up on select") {
+    auto warm = selectRepository(testRepoPath, {{"hot", 2, true}, {"nowhere"}});
+    REQUIRE(!warm == false);
+    REQUIRE((std::move(warm) >> read("hot/a/1"))->content() == "1");
+  }
+}
+
+TEST_CASE("tuning", "[repo] [tuning]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  SECTION("profiles are applied and reported") {
+    auto lowMemory = RepositoryOptions::of(Profile::LowMemory);
+    auto effective = tune(lowMemory);
+    REQUIRE(!effective == false);
+    REQUIRE(effective->cacheMaxSize_ == lowMemory.cacheMaxSize_);
+    REQUIRE(effective->mwindowSize_ == lowMemory.mwindowSize_);
+    REQUIRE(effective->mwindowMappedLimit_ == lowMemory.mwindowMappedLimit_);
+    REQUIRE(effective->treeCacheLimit_ == lowMemory.treeCacheLimit_);
+    REQUIRE(effective->fsync_ == false);
+
+    REQUIRE(tune({.blobCacheLimit_ = 4096}).has_value());
+    REQUIRE(tuning().blobCacheLimit_ == 4096);
+    REQUIRE(tuning().cacheMaxSize_ == lowMemory.cacheMaxSize_);
+  }
+
+  SECTION("select with a profile") {
+    auto ctx = selectRepository(testRepoPath, Profile::WriteHeavy)
+    >> add("a", "a")
+    >> commit("test", "test@test.com", "commit message")
+    >> read("a");
+    REQUIRE(!ctx == false);
+    REQUIRE(ctx->content() == "a");
+    REQUIRE(tuning().strictObjectCreation_ == false);
+  }
+
+  SECTION("hash verification") {
+    REQUIRE(tune({.verifyHashes_ = false}).has_value());
+    REQUIRE(tuning().verifyHashes_ == false);
+  }
+
+  REQUIRE(tune(RepositoryOptions::of(Profile::Default)).has_value());
+  REQUIRE(tuning().strictObjectCreation_ == true);
+  REQUIRE(tuning().verifyHashes_ == true);
+}
+
+TEST_CASE("readRange", "[crud] [readRange]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  std::string big;
+  for (size_t i = 0; big.size() < 100'000; ++i)
+    big += std::to_string(i) + ",";
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/big", big)
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  auto range = [&](const std::string& path, size_t offset, size_t length) {
+    auto copy = selectRepository(testRepoPath);
+    return std::move(copy) >> readRange(path, offset, length);
+  };
+
+  SECTION("committed") {
+    REQUIRE(range("docs/big", 0, 10)->content() == big.substr(0, 10));
+    REQUIRE(range("docs/big", 16'000, 1'000)->content() == big.substr(16'000, 1'000));
+    REQUIRE(range("docs/big", 99'990, 1'000)->content() == big.substr(99'990));
+    REQUIRE(range("docs/big", big.size(), 10)->content().empty());
+    REQUIRE(range("docs/big", 0, big.size())->content() == big);
+  }
+
+  SECTION("uncommitted and errors") {
+    ctx >> add("docs/new", "0123456789");
+    REQUIRE((std::move(ctx) >> readRange("docs/new", 3, 4))->content() == "3456");
+
+    auto deleted = selectRepository(testRepoPath) >> del("docs/big") >> readRange("docs/big", 0, 1);
+    REQUIRE(deleted.error()._type == ErrorType::Deleted);
+    REQUIRE(range("docs", 0, 1).error()._type == ErrorType::BadFile);
+    REQUIRE(!range("docs/nowhere", 0, 1) == true);
+  }
+}
+
+TEST_CASE("scan", "[query] [scan]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  std::vector<std::string> keys{"a.txt", "a/1", "a/2", "a0", "b/c.e", "b/c/d", "b/c/e/f", "b/x", "c"};
+  auto ctx = selectRepository(testRepoPath);
+  for (const auto& key : keys)
+    ctx >> add(key, key);
+  ctx >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+  std::sort(keys.begin(), keys.end());
+
+  auto keysOf = [](const ScanPage& page) {
+    std::vector<std::string> paths;
+    for (const auto& item : page.items_)
+      paths.push_back(item.path_.string());
+    return paths;
+  };
+
+  SECTION("ranges") {
+    auto all = scan(*ctx, "");
+    REQUIRE(keysOf(*all) == keys);
+    REQUIRE(all->next_.has_value() == false);
+
+    REQUIRE(keysOf(*scan(*ctx, "a/", "a0")) == std::vector<std::string>{"a/1", "a/2"});
+    REQUIRE(keysOf(*scan(*ctx, "a/2", "b/c/e")) == std::vector<std::string>{"a/2", "a0", "b/c.e", "b/c/d"});
+    REQUIRE(keysOf(*scan(*ctx, "b/c/", "b/y")) == std::vector<std::string>{"b/c/d", "b/c/e/f", "b/x"});
+    REQUIRE(scan(*ctx, "d")->items_.empty());
+  }
+
+  SECTION("pages") {
+    std::vector<std::string> paged;
+    auto page = scan(*ctx, "", "", 2);
+    while (true) {
+      REQUIRE(!page == false);
+      REQUIRE(page->items_.size() <= 2);
+      for (auto& key : keysOf(*page))
+        paged.push_back(key);
+      if (!page->next_)
+        break;
+
+      auto cursor = ScanCursor::fromToken(page->next_->token());
+      REQUIRE(!cursor == false);
+      page = scan(*ctx, *cursor, "", 2);
+    }
+    REQUIRE(paged == keys);
+  }
+
+  SECTION("cursors are bound to their root") {
+    auto page = scan(*ctx, "", "", 1);
+    ctx >> add("a/0", "new") >> commit("test", "test@test.com", "commit message");
+
+    REQUIRE(keysOf(*scan(*ctx, *page->next_, "", 1)) == std::vector<std::string>{"a/1"});
+    REQUIRE(keysOf(*scan(*ctx, "a.txt", "", 2)) == std::vector<std::string>{"a.txt", "a/0"});
+    REQUIRE(!ScanCursor::fromToken("nonsense") == true);
+  }
+}
+
+TEST_CASE("find", "[query] [find]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath);
+  for (const auto& key : {"README.md", "docs/a.md", "docs/b.txt", "docs/api/c.md", "docs/api/v1/d.md", "src/e.cpp", "src/docs/f.md"})
+    ctx >> add(key, key);
+  ctx >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  auto found = [&](const std::string& pattern, PatternKind kind = PatternKind::Glob) {
+    std::set<std::string> paths;
+    for (auto item : find(*ctx, pattern, kind)) {
+      REQUIRE(!item == false);
+      REQUIRE(item->isDir() == false);
+      paths.insert(item->path_.string());
+    }
+    return paths;
+  };
+
+  SECTION("glob") {
+    REQUIRE(found("docs/*.md") == std::set<std::string>{"docs/a.md"});
+    REQUIRE(found("docs/**/*.md") == std::set<std::string>{"docs/a.md", "docs/api/c.md", "docs/api/v1/d.md"});
+    REQUIRE(found("**/docs/*.md") == std::set<std::string>{"docs/a.md", "src/docs/f.md"});
+    REQUIRE(found("*/?.[a-m]*") == std::set<std::string>{"docs/a.md", "src/e.cpp"});
+    REQUIRE(found("docs/[!a]*") == std::set<std::string>{"docs/b.txt"});
+    REQUIRE(found("**").size() == 7);
+    REQUIRE(found("docs").empty()); // Directories are not yielded
+    REQUIRE(found("nothing/**").empty());
+  }
+
+  SECTION("regex") {
+    REQUIRE(found("docs/.*\\.md", PatternKind::Regex) == std::set<std::string>{"docs/a.md", "docs/api/c.md", "docs/api/v1/d.md"});
+    REQUIRE(found(".*/[a-c]\\.md", PatternKind::Regex) == std::set<std::string>{"docs/a.md", "docs/api/c.md"});
+    REQUIRE(found("src/e\\.cpp|README\\.md", PatternKind::Regex) == std::set<std::string>{"README.md", "src/e.cpp"});
+
+    auto malformed = find(*ctx, "docs/(", PatternKind::Regex);
+    auto first = malformed.begin();
+    REQUIRE(first != malformed.end());
+    REQUIRE(!*first == true);
+    REQUIRE((*first).error()._type == ErrorType::Application);
+  }
+
+  SECTION("uncommitted updates") {
+    ctx >> add("docs/api/v2/g.md", "new") >> del("docs/a.md") >> mv("docs/api/v1", "old/v1");
+    REQUIRE(found("docs/**/*.md") == std::set<std::string>{"docs/api/c.md", "docs/api/v2/g.md"});
+    REQUIRE(found("old/**") == std::set<std::string>{"old/v1/d.md"});
+
+    ctx >> del("src") >> add("src/docs/h.md", "new");
+    REQUIRE(found("src/**") == std::set<std::string>{"src/docs/h.md"});
+  }
+}
+
+TEST_CASE("index", "[crud] [index]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/a", "author:ann")
+  >> add("docs/b", "author:bob")
+  >> add("other/c", "author:ann")
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+
+  Index byAuthor{"author", "docs", [](const std::filesystem::path&, const std::string& content) {
+    return content.starts_with("author:") ? std::vector<std::string>{content.substr(7)} : std::vector<std::string>{};
+  }};
+
+  auto pathsOf = [&](const std::string& key) {
+    std::set<std::string> paths;
+    auto found = lookup(*ctx, "author", key);
+    for (const auto& item : found.value())
+      paths.insert(item.path_.string());
+    return paths;
+  };
+
+  ctx >> createIndex(byAuthor) >> commit("test", "test@test.com", "index");
+  REQUIRE(!ctx == false);
+  REQUIRE(pathsOf("ann") == std::set<std::string>{"docs/a"});
+  REQUIRE(pathsOf("bob") == std::set<std::string>{"docs/b"});
+  REQUIRE(lookup(*ctx, "author", "ann")->front().content().value() == "author:ann");
+
+  SECTION("maintained on commit") {
+    ctx >> add("docs/d", "author:ann")
+        >> add("docs/b", "author:ann")
+        >> commit("test", "test@test.com", "update");
+    REQUIRE(pathsOf("ann") == std::set<std::string>{"docs/a", "docs/b", "docs/d"});
+    REQUIRE(pathsOf("bob").empty());
+
+    ctx >> del("docs/a") >> mv("docs/d", "docs/e/d") >> commit("test", "test@test.com", "move");
+    REQUIRE(!ctx == false);
+    REQUIRE(pathsOf("ann") == std::set<std::string>{"docs/b", "docs/e/d"});
+  }
+
+  SECTION("registered again") {
+    ctx >> createIndex(byAuthor);
+    REQUIRE(ctx->updates_.empty());
+    REQUIRE(!(ctx >> createIndex({"bad/name", "", byAuthor.keys_})) == true);
+  }
+}
+
+TEST_CASE("full text", "[query] [fulltext]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath)
+  >> add("docs/a", "The quick brown fox")
+  >> add("docs/b", "A lazy dog")
+  >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+  git_oid first = *ctx->getCommitId();
+
+  auto index = TextIndex::open(*ctx, {.maxSegments_ = 2});
+  REQUIRE(!index == false);
+
+  auto found = [](auto&& result) {
+    std::vector<std::string> paths;
+    for (const auto& path : result.value())
+      paths.push_back(path.string());
+    return paths;
+  };
+
+  REQUIRE(found((*index)->search("quick FOX")) == std::vector<std::string>{"docs/a"});
+  REQUIRE(found((*index)->search("fox dog")).empty());
+
+  SECTION("live and historical") {
+    ctx >> add("docs/c", "a quick dog") >> add("docs/a", "The slow brown fox") >> commit("test", "test@test.com", "update");
+    ctx >> del("docs/b") >> commit("test", "test@test.com", "delete");
+    ctx >> mv("docs/c", "docs/d") >> commit("test", "test@test.com", "rename");
+    REQUIRE(!ctx == false);
+
+    // Live updates run on the I/O pool, after the commits returned
+    for (int i = 0; i < 500 && found((*index)->search("quick")) != std::vector<std::string>{"docs/d"}; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(found((*index)->search("quick")) == std::vector<std::string>{"docs/d"});
+    REQUIRE(found((*index)->search("dog")) == std::vector<std::string>{"docs/d"});
+    REQUIRE(found((*index)->search("quick", first)) == std::vector<std::string>{"docs/a"});
+    REQUIRE(found((*index)->search("dog", first)) == std::vector<std::string>{"docs/b"});
+    REQUIRE((*index)->segments() <= 2);
+  }
+
+  SECTION("reopened from disk") {
+    ctx >> add("docs/e", "jumps over") >> commit("test", "test@test.com", "more");
+    REQUIRE(!(*index)->update() == false); // Done with any queued live update
+    index->reset();
+
+    auto reopened = TextIndex::open(*ctx, {.live_ = false});
+    REQUIRE(!reopened == false);
+    REQUIRE(found((*reopened)->search("jumps")) == std::vector<std::string>{"docs/e"});
+    REQUIRE(found((*reopened)->search("fox", first)) == std::vector<std::string>{"docs/a"});
+
+    ctx >> add("docs/f", "jumps") >> commit("test", "test@test.com", "not live");
+    REQUIRE(found((*reopened)->search("jumps")) == std::vector<std::string>{"docs/e"});
+    REQUIRE((*reopened)->update().value() == 1);
+    REQUIRE(found((*reopened)->search("jumps")) == std::vector<std::string>{"docs/e", "docs/f"});
+  }
+
+  SECTION("corrupt segment") {
+    REQUIRE(!(*index)->update() == false);
+    index->reset();
+
+    // A term whose name claims more bytes than the file holds
+    auto dir = std::filesystem::path(git_repository_path(*ctx->repo_)) / "gd-fulltext";
+    for (const auto& ref : std::filesystem::directory_iterator(dir))
+      for (const auto& file : std::filesystem::directory_iterator(ref))
+        if (file.path().filename().string().starts_with("seg-")) {
+          std::ofstream out(file.path(), std::ios::binary | std::ios::trunc);
+          uint64_t header[2]{1, uint64_t{1} << 60};
+          out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        }
+
+    auto reopened = TextIndex::open(*ctx, {.live_ = false});
+    REQUIRE(!reopened == true);
+    REQUIRE(reopened.error()._type == ErrorType::BadFile);
+  }
+}
+
+TEST_CASE("grep", "[query] [grep]") {
+  SECTION("kernel") {
+    std::string haystack;
+    for (size_t i = 0; i < 1000; ++i)
+      haystack += "abcab"[(i * 7 + i / 13) % 5];
+
+    for (std::string needle : {"a", "ab", "cab", "abcab", "bcabcabcabcabcabcabcabcabcabcabcabca", "zz"}) {
+      std::vector<size_t> expected;
+      for (auto pos = haystack.find(needle); pos != string::npos; pos = haystack.find(needle, pos + 1))
+        expected.push_back(pos);
+      REQUIRE(occurrences(haystack, needle) == expected);
+    }
+    REQUIRE(occurrences(haystack, "").empty());
+    REQUIRE(occurrences("ab", "abc").empty());
+  }
+
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath);
+  for (size_t i = 0; i < 300; ++i)
+    ctx >> add("docs/" + std::to_string(i % 7) + "/" + std::to_string(i), "document " + std::to_string(i) + (i % 50 ? "" : " needle"));
+  ctx >> add("src/main", "needle in a haystack, another needle") >> commit("test", "test@test.com", "commit message");
+  REQUIRE(!ctx == false);
+  git_oid first = *ctx->getCommitId();
+  ctx >> add("src/main", "no more") >> commit("test", "test@test.com", "update");
+
+  auto found = [&](const Revision& rev, std::vector<std::string> patterns, const std::string& prefix, GrepOptions opts = {}) {
+    std::set<std::tuple<std::string, size_t, size_t>> matches;
+    for (auto match : grep(*ctx, rev, patterns, prefix, opts)) {
+      REQUIRE(!match == false);
+      matches.emplace(match->path_.string(), match->offset_, match->pattern_);
+    }
+    return matches;
+  };
+
+  auto docs = found("main", {"needle"}, "docs");
+  REQUIRE(docs.size() == 6);
+  REQUIRE(docs.contains({"docs/1/50", 12, 0}));
+
+  REQUIRE(found("main", {"needle", "haystack"}, "src", {.threads_ = 1}).empty());
+  REQUIRE(found(first, {"needle", "haystack"}, "src") ==
+          std::set<std::tuple<std::string, size_t, size_t>>{{"src/main", 0, 0}, {"src/main", 12, 1}, {"src/main", 30, 0}});
+  REQUIRE(found(first, {"needle"}, "", {.threads_ = 3, .batch_ = 1, .maxPending_ = 1}).size() == 8);
+
+  SECTION("abandoned and failed searches") {
+    for (auto match : grep(*ctx, "main", {"document"}, "", {.maxPending_ = 2})) {
+      REQUIRE(!match == false);
+      break;
+    }
+
+    auto missing = grep(*ctx, "main", {"needle"}, "nothing");
+    auto error = missing.begin();
+    REQUIRE(error != missing.end());
+    REQUIRE((*error).error()._type == ErrorType::NotFound);
+  }
+}
+
+TEST_CASE("manifest", "[query] [manifest]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath) >> add("docs/a", "a") >> commit("test", "test@test.com", "no manifest");
+  REQUIRE(Manifest::open(*ctx).error()._type == ErrorType::NotFound);
+
+  // Every manifest holds exactly the files of its commit's tree
+  auto matchesTree = [&] {
+    auto manifest = Manifest::open(*ctx);
+    REQUIRE(!manifest == false);
+    REQUIRE(git_oid_equal(&manifest->commitId(), ctx->getCommitId()));
+
+    size_t files = 0;
+    for (auto item : walk(*ctx)) {
+      if (item->isDir())
+        continue;
+      ++files;
+      auto found = manifest->find(item->path_);
+      REQUIRE(!found == false);
+      REQUIRE(git_oid_equal(&found->oid_, &item->oid_));
+      REQUIRE(found->mode_ == item->mode_);
+    }
+    REQUIRE(manifest->size() == files);
+  };
+
+  ctx >> keepManifests() >> add("docs/b", "b") >> add("docs/c/d", "d") >> add("e", "e") >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+  matchesTree();
+  auto first = *ctx->getCommitId();
+
+  ctx >> add("docs/b", "b2") >> del("e") >> mv("docs/c", "moved/c") >> add("docs/c/x", "x") >> commit("test", "test@test.com", "second");
+  REQUIRE(!ctx == false);
+  matchesTree();
+
+  ctx >> del("docs") >> add("docs/y", "y") >> commit("test", "test@test.com", "third");
+  REQUIRE(!ctx == false);
+  matchesTree();
+
+  auto manifest = Manifest::open(*ctx);
+  REQUIRE(manifest->find("/moved/c/d")->path_ == "moved/c/d");
+  REQUIRE(manifest->find("moved/c").error()._type == ErrorType::NotFound);
+
+  auto changes = diff(Manifest::open(*ctx, first).value(), *manifest);
+  std::set<std::pair<std::string, ChangeType>> changed;
+  for (const auto& change : changes)
+    changed.emplace(change.path_.string(), change.type_);
+
+  std::set<std::pair<std::string, ChangeType>> expected;
+  for (auto change : diff(*ctx, first, *ctx->getCommitId())) {
+    REQUIRE(!change == false);
+    if (change->type_ == ChangeType::Renamed) {
+      expected.emplace(change->from_.string(), ChangeType::Deleted);
+      expected.emplace(change->path_.string(), ChangeType::Added);
+    } else {
+      expected.emplace(change->path_.string(), change->type_);
+    }
+  }
+  REQUIRE(changed == expected);
+  REQUIRE(changed.contains({"docs/b", ChangeType::Deleted})); // Removed with "docs", "docs/y" is added after
+  REQUIRE(changed.contains({"docs/y", ChangeType::Added}));
+
+  // A truncated manifest holds paths past its end
+  char hex[GIT_OID_HEXSZ + 1];
+  git_oid_tostr(hex, sizeof(hex), ctx->getCommitId());
+  auto file = std::filesystem::path(git_repository_path(*ctx->repo_)) / "gd-manifest" / hex;
+  std::filesystem::resize_file(file, std::filesystem::file_size(file) - 1);
+  REQUIRE(Manifest::open(*ctx).error()._type == ErrorType::BadFile);
+}
+
+TEST_CASE("path filters", "[query] [history]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath) >> add("a/x", "x") >> commit("test", "test@test.com", "unfiltered");
+  auto unfiltered = *ctx->getCommitId();
+
+  ctx >> keepPathFilters() >> add("a/x", "x1") >> add("b/y", "y") >> commit("test", "test@test.com", "first");
+  auto first = *ctx->getCommitId();
+  ctx >> add("b/z", "z") >> commit("test", "test@test.com", "second");
+  auto second = *ctx->getCommitId();
+  ctx >> del("b") >> commit("test", "test@test.com", "third");
+  auto third = *ctx->getCommitId();
+  ctx >> mv("a", "c/a") >> commit("test", "test@test.com", "fourth");
+  REQUIRE(!ctx == false);
+
+  auto filters = PathFilters::open(*ctx);
+  REQUIRE(!filters == false);
+  REQUIRE(filters->size() == 4);
+  REQUIRE(!filters->find(unfiltered));
+  REQUIRE(filters->mayHaveChanged(unfiltered, "anything"));
+
+  // Changed paths, their directories, and files under an updated directory
+  auto secondFilter = filters->find(second);
+  REQUIRE(secondFilter->mayHaveChanged("b/z"));
+  REQUIRE(secondFilter->mayHaveChanged("/b/"));
+  REQUIRE(secondFilter->mayHaveChanged(""));
+  REQUIRE(!secondFilter->mayHaveChanged("a/x"));
+  REQUIRE(filters->find(third)->mayHaveChanged("b/y"));
+  REQUIRE(filters->mayHaveChanged(*ctx->getCommitId(), "a/x"));
+  REQUIRE(filters->mayHaveChanged(*ctx->getCommitId(), "c/a/x"));
+
+  size_t versions = 0;
+  for (auto version : history(*ctx, "a/x")) {
+    REQUIRE(!version == false);
+    ++versions;
+  }
+  REQUIRE(versions == 2);
+
+  REQUIRE(changedSince(*ctx, first, "b").value());
+  REQUIRE(changedSince(*ctx, second, "b/y").value());
+  REQUIRE(!changedSince(*ctx, third, "b").value());
+  REQUIRE(changedSince(*ctx, third, "c/a/x").value());
+  REQUIRE(!changedSince(*ctx, unfiltered, "nothing").value());
+  REQUIRE(changedSince(*ctx, unfiltered).value());
+
+  // About 1% false positives
+  for (int i = 0; i < 200; ++i)
+    ctx >> add("many/" + to_string(i), "m");
+  ctx >> commit("test", "test@test.com", "many");
+  filters = PathFilters::open(*ctx);
+  REQUIRE(filters->size() == 5);
+
+  size_t positives = 0;
+  for (int i = 0; i < 1000; ++i)
+    positives += filters->mayHaveChanged(*ctx->getCommitId(), "other/" + to_string(i));
+  REQUIRE(positives < 50);
+}
+
+TEST_CASE("json fields", "[read] [json]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  const string doc = R"({ "name": "Steven", "a/b": {"c~d": [1, "two", {"x": null}]}, "esc\"aped": "q", )"
+                     R"("born": 1954, "books": [], "tags": {} })";
+  REQUIRE(jsonField(doc, "/name").value() == "\"Steven\"");
+  REQUIRE(jsonField(doc, "/a~1b/c~0d/1").value() == "\"two\"");
+  REQUIRE(jsonField(doc, "/a~1b/c~0d/2/x").value() == "null");
+  REQUIRE(jsonField(doc, "/esc\"aped").value() == "\"q\"");
+  REQUIRE(jsonField(doc, "/born").value() == "1954");
+  REQUIRE(jsonField(doc, "").value() == doc.substr(0, doc.size()));
+  REQUIRE(jsonField(doc, "/missing").error()._type == ErrorType::NotFound);
+  REQUIRE(jsonField(doc, "/a~1b/c~0d/3").error()._type == ErrorType::NotFound);
+  REQUIRE(jsonField(doc, "/born/x").error()._type == ErrorType::NotFound);
+  REQUIRE(jsonField(doc, "name").error()._type == ErrorType::Application);
+  REQUIRE(jsonField(R"({"a": [1, 2)", "/a/5").error()._type == ErrorType::BadFile);
+
+  // Replaced, or added to objects and arrays, the rest of the document is kept as is
+  REQUIRE(jsonPatch(doc, "/born", "1955").value() == R"({ "name": "Steven", "a/b": {"c~d": [1, "two", {"x": null}]}, "esc\"aped": "q", "born": 1955, "books": [], "tags": {} })");
+  REQUIRE(jsonPatch(R"({"a": 1 })", "/b", R"( {"c": [2]} )").value() == R"({"a": 1,"b":{"c": [2]} })");
+  REQUIRE(jsonPatch(R"({"a": []})", "/a/-", "1").value() == R"({"a": [1]})");
+  REQUIRE(jsonPatch(R"({"a": [1]})", "/a/-", "\"2\"").value() == R"({"a": [1,"2"]})");
+  REQUIRE(jsonPatch(R"({})", "/new\"key", "true").value() == R"({"new\"key":true})");
+  REQUIRE(jsonPatch(doc, "", "[]").value() == "[]");
+  REQUIRE(jsonPatch(doc, "/born", "19 55").error()._type == ErrorType::Application);
+  REQUIRE(jsonPatch(doc, "/books/0", "1").error()._type == ErrorType::NotFound);
+
+  auto ctx = selectRepository(testRepoPath) >> add("people/pinker.json", doc) >> commit("test", "test@test.com", "json");
+  REQUIRE(!ctx == false);
+
+  auto field = [&](const std::string& path, const std::string& pointer) {
+    auto copy = selectRepository(testRepoPath);
+    return std::move(copy) >> readField(path, pointer);
+  };
+
+  // Repeated reads, the second served by the fields remembered for the blob
+  for (int i = 0; i < 2; ++i) {
+    REQUIRE(field("people/pinker.json", "/a~1b/c~0d/2")->content() == "{\"x\": null}");
+    REQUIRE(field("people/pinker.json", "/name")->content() == "\"Steven\"");
+    REQUIRE(field("people/pinker.json", "/a~1b")->content() == "{\"c~d\": [1, \"two\", {\"x\": null}]}");
+  }
+  REQUIRE(field("people/pinker.json", "/nope").error()._type == ErrorType::NotFound);
+  REQUIRE(field("people", "/name").error()._type == ErrorType::BadFile);
+
+  ctx >> patchField("people/pinker.json", "/name", "\"Steven Arthur\"") >> patchField("people/pinker.json", "/books/-", "\"The Blank Slate\"")
+      >> commit("test", "test@test.com", "patched");
+  REQUIRE(!ctx == false);
+  REQUIRE((ctx >> read("people/pinker.json"))->content() ==
+          R"({ "name": "Steven Arthur", "a/b": {"c~d": [1, "two", {"x": null}]}, "esc\"aped": "q", "born": 1954, "books": ["The Blank Slate"], "tags": {} })");
+
+  // Uncommitted updates are read
+  auto pending = selectRepository(testRepoPath) >> patchField("people/pinker.json", "/born", "1954.0");
+  REQUIRE((std::move(pending) >> readField("people/pinker.json", "/born"))->content() == "1954.0");
+  REQUIRE((selectRepository(testRepoPath) >> patchField("people/pinker.json", "/born/x", "1")).error()._type == ErrorType::NotFound);
+
+  // A malformed document isn't remembered, its fields are read again
+  REQUIRE(!(selectRepository(testRepoPath) >> add("people/broken.json", R"({"a": {"x": 1}, "b": [1, 2)") >> commit("test", "test@test.com", "broken")) == false);
+  REQUIRE(field("people/broken.json", "/b/5").error()._type == ErrorType::BadFile);
+  REQUIRE(field("people/broken.json", "/b").error()._type == ErrorType::BadFile);
+}
+
+TEST_CASE("commit index", "[query] [commits]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  const string other("other");
+  cleanRepo(testRepoPath);
+
+  auto start = chrono::system_clock::now() - 1s;
+  auto ctx = selectRepository(testRepoPath) >> add("a", "a") >> commit("alice", "alice@here.com", "Not indexed");
+  auto first = *ctx->getCommitId();
+
+  ctx >> keepCommitIndex() >> add("b", "b") >> commit("alice", "alice@here.com", "Fix the parser")
+      >> add("c", "c") >> commit("bob", "bob@there.com", "Parser speedup")
+      >> createBranch(other) >> selectBranch(other)
+      >> add("d", "d") >> commit("Alice", "alice@here.com", "Docs, on another branch");
+  REQUIRE(!ctx == false);
+  auto end = chrono::system_clock::now() + 1s;
+
+  auto index = CommitIndex::open(*ctx);
+  REQUIRE(!index == false);
+  REQUIRE(index->size() == 3);
+
+  auto all = index->find({});
+  REQUIRE(all.size() == 3);
+  REQUIRE(all[0].author_ == "alice");
+  REQUIRE(git_oid_equal(&*all[0].parent_, &first));
+  REQUIRE(all[0].ref_ == "refs/heads/main");
+  REQUIRE(all[0].terms_ == vector<string>{"fix", "parser", "the"});
+  REQUIRE(git_oid_equal(&all[2].commit_, ctx->getCommitId()));
+  REQUIRE(all[2].ref_ == "refs/heads/other");
+  REQUIRE(all[0].time_ >= start);
+
+  // By author name or email, case insensitive, by ref, message terms and time
+  REQUIRE(index->find({.author_ = "ALICE"}).size() == 2);
+  REQUIRE(index->find({.author_ = "bob@there.com"}).size() == 1);
+  REQUIRE(index->find({.author_ = "carol"}).empty());
+  REQUIRE(index->find({.ref_ = "other"}).size() == 1);
+  REQUIRE(index->find({.author_ = "alice", .ref_ = "refs/heads/main"}).size() == 1);
+  REQUIRE(index->find({.message_ = "PARSER"}).size() == 2);
+  REQUIRE(index->find({.message_ = "parser fix"}).size() == 1);
+  REQUIRE(index->find({.since_ = start, .until_ = end}).size() == 3);
+  REQUIRE(index->find({.since_ = end}).empty());
+  REQUIRE(index->find({.until_ = start}).empty());
+  REQUIRE(index->find({.since_ = start, .author_ = "alice", .limit_ = 1})[0].terms_[0] == "fix");
+
+  // Later commits are read by the next open, an opened index is a snapshot
+  ctx >> add("e", "e") >> commit("bob", "bob@there.com", "More");
+  REQUIRE(index->size() == 3);
+  REQUIRE(CommitIndex::open(*ctx)->find({.author_ = "bob"}).size() == 2);
+
+  // Loaded a few commits at a time, found by time across the loads
+  for (int i = 0; i < 5; ++i) {
+    ctx >> add("f", to_string(i)) >> commit(i % 2 ? "bob" : "carol", "x@there.com", "Load " + to_string(i));
+    REQUIRE(CommitIndex::open(*ctx)->size() == size_t(5 + i));
+  }
+  auto loaded = CommitIndex::open(*ctx)->find({});
+  REQUIRE(loaded.size() == 9);
+  REQUIRE(std::is_sorted(loaded.begin(), loaded.end(), [](auto& a, auto& b) { return a.time_ < b.time_; }));
+  REQUIRE(git_oid_equal(&loaded.back().commit_, ctx->getCommitId()));
+  REQUIRE(CommitIndex::open(*ctx)->find({.author_ = "bob"}).size() == 4);
+  REQUIRE(CommitIndex::open(*ctx)->find({.author_ = "x@there.com", .limit_ = 3}).size() == 3);
+  REQUIRE(index->size() == 3);
+}
+
+Task<Result<string>> asyncSession(string repoPath, string branch) {
+  auto ctx = co_await async::selectRepository(repoPath);
+  ctx = co_await async::then(std::move(ctx), selectBranch(branch));
+  ctx = co_await async::add(std::move(ctx), branch + "/file", "content of " + branch);
+  ctx = co_await async::commit(std::move(ctx), "async", "async@test.com", "on " + branch);
+  auto read = co_await async::read(std::move(ctx), branch + "/file");
+  if (!read)
+    co_return gd_unexpected(std::move(read));
+  co_return read->content();
+}
+
+TEST_CASE("async", "[async]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath) >> add("a", "a") >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+
+  // Many sessions over the pool's threads, each on its own branch
+  constexpr size_t sessions = 64;
+  vector<Task<Result<string>>> tasks;
+  for (size_t i = 0; i < sessions; ++i) {
+    auto branch = "session" + to_string(i);
+    ctx >> createBranch(branch);
+    tasks.push_back(asyncSession(testRepoPath, branch));
+  }
+  REQUIRE(!ctx == false);
+
+  auto contents = syncWait(whenAll(std::move(tasks)));
+  REQUIRE(contents.size() == sessions);
+  for (size_t i = 0; i < sessions; ++i)
+    REQUIRE(contents[i].value() == "content of session" + to_string(i));
+
+  // Errors propagate through awaits
+  auto failed = syncWait(asyncSession(testRepoPath, "no/such/../branch"));
+  REQUIRE(!failed == true);
+  auto missing = syncWait([]() -> Task<Result<ReadContext>> {
+    co_return co_await async::read(selectRepository(testRepoPath), "nowhere");
+  }());
+  REQUIRE(!missing == true);
+}
+
+TEST_CASE("repository registry", "[select]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  const static string otherRepoPath{"/tmp/test/unit-other"};
+  cleanRepo(testRepoPath);
+  cleanRepo(otherRepoPath);
+
+  auto ctx = selectRepository(testRepoPath) >> add("a", "a") >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+
+  // Re-selects keep being served while other repositories come and go
+  atomic<size_t> failures{0};
+  vector<jthread> readers;
+  for (size_t i = 0; i < 4; ++i)
+    readers.emplace_back([&failures] {
+      for (size_t j = 0; j < 200; ++j) {
+        auto found = selectRepository(testRepoPath) >> read("a");
+        if (!found || found->content() != "a")
+          ++failures;
+      }
+    });
+  for (size_t i = 0; i < 10; ++i) {
+    auto other = selectRepository(otherRepoPath) >> add("b", "b") >> commit("test", "test@test.com", "other");
+    REQUIRE(!other == false);
+    REQUIRE(cleanRepo(otherRepoPath) == true);
+  }
+  readers.clear();
+  REQUIRE(failures == 0);
+
+  // A re-select follows the branch's tip
+  auto moved = selectRepository(testRepoPath) >> add("a", "b") >> commit("test", "test@test.com", "second");
+  REQUIRE(!moved == false);
+  auto latest = selectRepository(testRepoPath) >> read("a");
+  REQUIRE(latest->content() == "b");
+
+  // A removed repository is recreated, empty, by its next select
+  REQUIRE(cleanRepo(testRepoPath) == true);
+  auto removed = selectRepository(testRepoPath) >> read("a");
+  REQUIRE(!removed == true);
+}
+
+TEST_CASE("branch tips", "[commit] [branch]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath) >> add("a", "first") >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+  const git_oid first = *ctx->getCommitId();
+  REQUIRE(ctx->isTip().value() == true);
+  auto tip = ctx->tip();
+  REQUIRE(git_oid_equal(&tip.value(), &first));
+
+  // Moved by another context
+  auto other = selectRepository(testRepoPath) >> add("a", "second") >> commit("test", "test@test.com", "second");
+  REQUIRE(!other == false);
+  REQUIRE(ctx->isTip().value() == false);
+  REQUIRE(ctx->rebase().has_value());
+  REQUIRE(ctx->isTip().value() == true);
+  REQUIRE(git_oid_equal(ctx->getCommitId(), other->getCommitId()));
+
+  // A created branch is at the tip it was created from
+  ctx = std::move(ctx).and_then(createBranch("tips")).and_then(selectBranch("tips"));
+  REQUIRE(ctx->isTip().value() == true);
+
+  // Moved by a writer outside the library
+  git_reference *reset{nullptr};
+  REQUIRE(git_reference_create(&reset, *ctx->repo_, "refs/heads/tips", &first, 1, "reset") == 0);
+  git_reference_free(reset);
+  REQUIRE(ctx->rebase().has_value()); // Reads the ref
+  REQUIRE(git_oid_equal(ctx->getCommitId(), &first));
+  auto reread = ctx >> read("a");
+  REQUIRE(reread->content() == "first");
+
+  // Otherwise seen once the ref is checked again
+  const git_oid second = *other->getCommitId();
+  REQUIRE(git_reference_create(&reset, *reread->repo_, "refs/heads/tips", &second, 1, "forward") == 0);
+  git_reference_free(reset);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE(reread->isTip().value() == false);
+  auto tipped = reread->tip();
+  REQUIRE(git_oid_equal(&tipped.value(), &second));
+}
+
+TEST_CASE("thread session", "[session]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto ctx = selectRepository(testRepoPath) >> add("a", "a") >> commit("test", "test@test.com", "first");
+  REQUIRE(!ctx == false);
+
+  // Updates are kept between disjoint calls
+  REQUIRE(db.begin().has_value());
+  db >> add("b", "b");
+  db >> add("c", "c");
+  auto pending = db >> read("b");
+  REQUIRE(pending->content() == "b");
+  REQUIRE(pending->repo_ != nullptr); // The read keeps its repository and branch, the session the rest
+  REQUIRE(pending->ref_.empty() == false);
+  auto& committed = db >> commit("test", "test@test.com", "session");
+  REQUIRE(!committed == false);
+  db.end();
+
+  // A failed operation leaves the session failed
+  REQUIRE(db.begin().has_value());
+  db >> add("g", "g");
+  auto missing = db >> read("nowhere");
+  REQUIRE(!missing == true);
+  REQUIRE(!(db >> commit("test", "test@test.com", "failed")) == true);
+  db.end();
+  REQUIRE(!(selectRepository(testRepoPath) >> read("g")) == true);
+
+  auto persisted = selectRepository(testRepoPath) >> read("c");
+  REQUIRE(persisted->content() == "c");
+
+  // Without a session, each call starts afresh
+  db >> add("d", "d");
+  auto fresh = db >> read("d");
+  REQUIRE(!fresh == true);
+
+  // An ended session drops its updates, a failed one stays failed until begun again
+  REQUIRE(db.begin().has_value());
+  db >> add("e", "e");
+  db.end();
+  REQUIRE(db.begin().has_value());
+  auto dropped = db >> read("e");
+  REQUIRE(!dropped == true);
+  REQUIRE(!(db >> selectBranch("no/such/branch")) == true);
+  REQUIRE(!(db >> add("f", "f")) == true);
+  selectRepository(testRepoPath); // The thread's branch was switched to the missing one
+  REQUIRE(db.begin().has_value());
+  REQUIRE(!(db >> add("f", "f")) == false);
+  db.end();
+}
+
+TEST_CASE("serializable", "[commit] [conflict]") {
+  const static string testRepoPath{"/tmp/test/unit"};
+  cleanRepo(testRepoPath);
+
+  auto seed = selectRepository(testRepoPath) >> add("a", "1") >> add("c", "1") >> commit("test", "test@test.com", "seed");
+  REQUIRE(!seed == false);
+
+  REQUIRE(db.begin().has_value());
+  REQUIRE(!(db >> serializable()) == false);
+
+  // A commit on a file not read doesn't conflict, the transaction is committed on top of it
+  auto a = db >> read("a");
+  db >> add("b", a->content() + "+1");
+  auto other = selectRepository(testRepoPath) >> add("c", "2") >> commit("test", "test@test.com", "other");
+  REQUIRE(!other == false);
+  auto& committed = db >> commit("test", "test@test.com", "b from a");
+  REQUIRE(!committed == false);
+  auto head = selectRepository(testRepoPath) >> read("c");
+  REQUIRE(head->content() == "2");
+
+  // A commit on a file read conflicts
+  a = db >> read("a");
+  db >> add("b", a->content() + "+2");
+  auto writer = selectRepository(testRepoPath) >> add("a", "2") >> commit("test", "test@test.com", "a changed");
+  REQUIRE(!writer == false);
+  auto& conflicted = db >> commit("test", "test@test.com", "b from stale a");
+  REQUIRE(!conflicted == true);
+  REQUIRE(conflicted.error()._type == ErrorType::Conflict);
+
+  // A file read as missing fails the transaction, it never commits on the file's absence
+  REQUIRE(db.begin().has_value());
+  db >> serializable();
+  auto missing = db >> read("p");
+  REQUIRE(!missing == true);
+  auto creator = selectRepository(testRepoPath) >> add("p", "p") >> commit("test", "test@test.com", "p");
+  REQUIRE(!creator == false);
+  auto& failed = db >> add("q", "no p");
+  REQUIRE(!failed == true);
+  REQUIRE(failed.error()._type == missing.error()._type);
+  db.end();
+
+  // Files patched, read through other means than read, conflict with a concurrent patch too
+  REQUIRE(!(selectRepository(testRepoPath) >> add("x.json", R"({"a": 0, "b": 0})") >> commit("test", "test@test.com", "x")) == false);
+  auto first = selectRepository(testRepoPath) >> serializable() >> patchField("x.json", "/a", "1");
+  auto second = selectRepository(testRepoPath) >> serializable() >> patchField("x.json", "/b", "2");
+  REQUIRE(!(std::move(second) >> commit("test", "test@test.com", "b patched")) == false);
+  auto lost = std::move(first) >> commit("test", "test@test.com", "a patched");
+  REQUIRE(!lost == true);
+  REQUIRE(lost.error()._type == ErrorType::Conflict);
+  REQUIRE((selectRepository(testRepoPath) >> read("x.json"))->content() == R"({"a": 0, "b": 2})");
+}